@@ -0,0 +1,136 @@
+#include "audio_backend.h"
+
+#include <alsa/asoundlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+#include "trace.h"
+
+namespace {
+
+// Direct ALSA playback. The hardware buffer has room for eight periods
+// so a late wakeup does not underrun, but the writer only keeps three
+// queued: the delay to the speaker is what --period asks for, and low
+// latency shortens it without reopening the device.
+class AlsaBackend : public AudioBackend {
+public:
+    AlsaBackend(size_t periodFrames, std::string device)
+        : periodFrames_(periodFrames), device_(std::move(device)) {}
+    ~AlsaBackend() override { stop(); }
+
+    bool start(int sampleRate, Render render) override {
+        if (running_) {
+            return true;
+        }
+        int err = snd_pcm_open(&pcm_, device_.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+        if (err < 0) {
+            error_ = "cannot open ALSA device " + device_ + ": " + snd_strerror(err);
+            pcm_ = nullptr;
+            return false;
+        }
+        unsigned int bufferUs = static_cast<unsigned int>(8 * periodFrames_ * 1000000ull / sampleRate);
+        err = snd_pcm_set_params(pcm_, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED,
+                                 1, static_cast<unsigned int>(sampleRate), 1, bufferUs);
+        if (err >= 0) {
+            // Start on the first period rather than a full buffer, which
+            // the writer never reaches.
+            snd_pcm_sw_params_t* sw;
+            snd_pcm_sw_params_alloca(&sw);
+            snd_pcm_sw_params_current(pcm_, sw);
+            snd_pcm_sw_params_set_start_threshold(pcm_, sw, 1);
+            err = snd_pcm_sw_params(pcm_, sw);
+        }
+        if (err < 0) {
+            error_ = "cannot configure ALSA device " + device_ + ": " + snd_strerror(err);
+            snd_pcm_close(pcm_);
+            pcm_ = nullptr;
+            return false;
+        }
+        sampleRate_ = sampleRate;
+        render_ = std::move(render);
+        written_ = 0;
+        played_ = 0;
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() override {
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        thread_.join();
+        snd_pcm_drop(pcm_);
+        snd_pcm_close(pcm_);
+        pcm_ = nullptr;
+    }
+
+    bool running() const override { return running_; }
+    uint64_t playedFrames() const override { return played_; }
+    void setLowLatency(bool on) override { lowLatency_ = on; }
+    const char* name() const override { return "alsa"; }
+
+private:
+    void run() {
+        CW_TRACE_THREAD("audio");
+        std::vector<short> buffer(std::max(periodFrames_, LOW_LATENCY_PERIOD_FRAMES));
+        while (running_) {
+            size_t frames = lowLatency_ ? std::min(periodFrames_, LOW_LATENCY_PERIOD_FRAMES) : periodFrames_;
+            snd_pcm_sframes_t delay = 0;
+            if (snd_pcm_delay(pcm_, &delay) < 0 || delay < 0) {
+                delay = 0;
+            }
+            played_ = written_ > static_cast<uint64_t>(delay) ? written_ - delay : 0;
+
+            snd_pcm_sframes_t excess = delay - static_cast<snd_pcm_sframes_t>(2 * frames);
+            if (excess > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(excess * 1000000 / sampleRate_));
+                continue;
+            }
+            render_(buffer.data(), frames);
+            size_t done = 0;
+            while (done < frames && running_) {
+                snd_pcm_sframes_t n = snd_pcm_writei(pcm_, buffer.data() + done, frames - done);
+                if (n < 0) {
+                    // An underrun costs a gap in the sound, not the timeline:
+                    // frame numbers still count only what was written.
+                    if (n == -EPIPE) {
+                        MorseCore::metrics().audioUnderruns.add();
+                    }
+                    CW_TRACE_SPAN("playback", "recover");
+                    if (snd_pcm_recover(pcm_, static_cast<int>(n), 1) < 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                    continue;
+                }
+                done += static_cast<size_t>(n);
+            }
+            written_ += done;
+        }
+    }
+
+    size_t periodFrames_;
+    std::string device_;
+    snd_pcm_t* pcm_ = nullptr;
+    int sampleRate_ = 0;
+    Render render_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> lowLatency_{false};
+    std::atomic<uint64_t> played_{0};
+    uint64_t written_ = 0;   // writer thread only
+};
+
+} // namespace
+
+std::unique_ptr<AudioBackend> makeAlsaBackend(const AudioOptions& options) {
+    return std::unique_ptr<AudioBackend>(
+        new AlsaBackend(options.period(), options.target.empty() ? "default" : options.target));
+}
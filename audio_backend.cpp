@@ -0,0 +1,173 @@
+#include "audio_backend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "metrics.h"
+#include "trace.h"
+#include "wav_writer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Stands in for a sound card: keeps two periods queued and "plays"
+// them against the steady clock, so every mode keeps its timing with
+// no device at all. Subclasses decide what happens to the samples.
+class PacedBackend : public AudioBackend {
+public:
+    explicit PacedBackend(size_t periodFrames) : periodFrames_(periodFrames) {}
+    ~PacedBackend() override { stop(); }
+
+    bool start(int sampleRate, Render render) override {
+        if (running_) {
+            return true;
+        }
+        if (!open(sampleRate)) {
+            return false;
+        }
+        sampleRate_ = sampleRate;
+        render_ = std::move(render);
+        rendered_ = 0;
+        startTime_ = Clock::now();
+        running_ = true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() override {
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        thread_.join();
+        close();
+    }
+
+    bool running() const override { return running_; }
+
+    uint64_t playedFrames() const override {
+        if (!running_) {
+            return 0;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime_);
+        uint64_t frames = static_cast<uint64_t>(elapsed.count()) * sampleRate_ / 1000000000;
+        return std::min<uint64_t>(frames, rendered_);
+    }
+
+    void setLowLatency(bool on) override { lowLatency_ = on; }
+
+protected:
+    virtual bool open(int /*sampleRate*/) { return true; }
+    virtual void consume(const short* /*samples*/, size_t /*frames*/) {}
+    virtual void close() {}
+
+private:
+    void run() {
+        CW_TRACE_THREAD("audio");
+        std::vector<short> buffer;
+        bool dry = false;
+        while (running_) {
+            size_t frames = lowLatency_ ? std::min(periodFrames_, LOW_LATENCY_PERIOD_FRAMES) : periodFrames_;
+            uint64_t rendered = rendered_;
+            uint64_t due = rendered > 2 * frames ? rendered - 2 * frames : 0;
+            std::this_thread::sleep_until(startTime_ + std::chrono::nanoseconds(due * 1000000000 / sampleRate_));
+            // Woken after everything queued would have played: a real
+            // device would have run dry. The catch-up periods that follow
+            // belong to the same gap.
+            Clock::time_point now = Clock::now();
+            Clock::time_point drained = startTime_ + std::chrono::nanoseconds(rendered * 1000000000 / sampleRate_);
+            bool late = rendered > 0 && now > drained;
+            if (late && !dry) {
+                MorseCore::metrics().audioUnderruns.add();
+                CW_TRACE_COMPLETE("playback", "underrun", drained, now);
+            }
+            dry = late;
+            buffer.resize(frames);
+            render_(buffer.data(), frames);
+            consume(buffer.data(), frames);
+            rendered_ = rendered + frames;
+        }
+    }
+
+    size_t periodFrames_;
+    int sampleRate_ = 0;
+    Render render_;
+    std::thread thread_;
+    Clock::time_point startTime_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> lowLatency_{false};
+    std::atomic<uint64_t> rendered_{0};
+};
+
+class NullBackend : public PacedBackend {
+public:
+    using PacedBackend::PacedBackend;
+    const char* name() const override { return "null"; }
+};
+
+// Everything played goes to a 16-bit mono WAV file, in real time.
+class WavBackend : public PacedBackend {
+public:
+    WavBackend(size_t periodFrames, std::string path)
+        : PacedBackend(periodFrames), path_(std::move(path)) {}
+    ~WavBackend() override { stop(); }   // close() must run while this is still a WavBackend
+
+    const char* name() const override { return "wav"; }
+
+protected:
+    bool open(int sampleRate) override {
+        if (!writer_.open(path_, sampleRate)) {
+            error_ = writer_.error();
+            return false;
+        }
+        return true;
+    }
+
+    void consume(const short* samples, size_t frames) override { writer_.write(samples, frames); }
+
+    void close() override { writer_.close(); }
+
+private:
+    std::string path_;
+    MorseCore::WavWriter writer_;
+};
+
+} // namespace
+
+std::vector<std::string> audioBackendNames() {
+    std::vector<std::string> names;
+#ifdef CW_HAVE_SFML
+    names.push_back("sfml");
+#endif
+#ifdef CW_HAVE_ALSA
+    names.push_back("alsa");
+#endif
+    names.push_back("null");
+    names.push_back("wav");
+    return names;
+}
+
+std::unique_ptr<AudioBackend> makeAudioBackend(const AudioOptions& options, std::string& error) {
+    std::string name = options.backend.empty() ? audioBackendNames().front() : options.backend;
+#ifdef CW_HAVE_SFML
+    if (name == "sfml") return makeSfmlBackend(options);
+#endif
+#ifdef CW_HAVE_ALSA
+    if (name == "alsa") return makeAlsaBackend(options);
+#endif
+    if (name == "null") {
+        return std::unique_ptr<AudioBackend>(new NullBackend(options.period()));
+    }
+    if (name == "wav") {
+        std::string path = options.target.empty() ? "cw_trainer.wav" : options.target;
+        return std::unique_ptr<AudioBackend>(new WavBackend(options.period(), path));
+    }
+    error = "unknown audio output '" + name + "'; this build has:";
+    for (const std::string& n : audioBackendNames()) {
+        error += " " + n;
+    }
+    return nullptr;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Where the trainer's audio goes. A backend owns the output and
+// the thread that feeds it: it asks for one period of samples at
+// a time as the output drains, and reports how many frames have
+// been played so AudioEngine can put times on frame numbers. One
+// is chosen at startup with makeAudioBackend().
+// ------------------------------------------------------------
+class AudioBackend {
+public:
+    // Fills out[0..frames) with the next frames of the timeline.
+    // Called on the backend's thread.
+    using Render = std::function<void(short* out, size_t frames)>;
+
+    // Frames asked for at a time unless --period says otherwise, and
+    // the most asked for while low latency is on.
+    static constexpr size_t DEFAULT_PERIOD_FRAMES = 512;
+    static constexpr size_t LOW_LATENCY_PERIOD_FRAMES = 64;
+
+    virtual ~AudioBackend() = default;
+
+    // Opens the output and starts pulling periods. On failure returns
+    // false and error() says why.
+    virtual bool start(int sampleRate, Render render) = 0;
+    virtual void stop() = 0;
+    virtual bool running() const = 0;
+
+    // Frames played so far. May lag the true position, never lead it.
+    virtual uint64_t playedFrames() const = 0;
+
+    // Short periods while keying, so a key edge is heard within a few
+    // milliseconds; costs wakeups and underrun margin.
+    virtual void setLowLatency(bool on) = 0;
+
+    virtual const char* name() const = 0;
+    const std::string& error() const { return error_; }
+
+protected:
+    std::string error_;
+};
+
+struct AudioOptions {
+    std::string backend;      // "sfml", "alsa", "wav" or "null"; empty = first available
+    std::string target;       // ALSA device or WAV file; empty = the backend's default
+    size_t periodFrames = 0;  // 0 = AudioBackend::DEFAULT_PERIOD_FRAMES
+
+    size_t period() const {
+        return periodFrames ? periodFrames : AudioBackend::DEFAULT_PERIOD_FRAMES;
+    }
+};
+
+// Backends built into this binary, best first.
+std::vector<std::string> audioBackendNames();
+
+// nullptr (with error set) when the backend is unknown or not built in.
+std::unique_ptr<AudioBackend> makeAudioBackend(const AudioOptions& options, std::string& error);
+
+// Defined only when the matching library was found at build time.
+std::unique_ptr<AudioBackend> makeSfmlBackend(const AudioOptions& options);
+std::unique_ptr<AudioBackend> makeAlsaBackend(const AudioOptions& options);
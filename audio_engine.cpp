@@ -0,0 +1,136 @@
+#include "audio_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "metrics.h"
+
+namespace {
+
+// Long enough that a cut tone ends without a click, short enough that
+// the cut is heard as immediate.
+const int CUT_FADE_MS = 5;
+
+} // namespace
+
+AudioEngine::AudioEngine(int sampleRate, std::unique_ptr<AudioBackend> backend)
+    : sampleRate_(sampleRate),
+      backend_(std::move(backend)),
+      clock_(sampleRate) {}
+
+AudioEngine::~AudioEngine() {
+    backend_->stop();
+}
+
+bool AudioEngine::start() {
+    if (backend_->running()) {
+        return true;
+    }
+    return backend_->start(sampleRate_, [this](short* out, size_t frames) { render(out, frames); });
+}
+
+uint64_t AudioEngine::enqueue(const short* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t startFrame = handedOut_ + queue_.size();
+    queue_.insert(queue_.end(), samples, samples + count);
+    return startFrame;
+}
+
+uint64_t AudioEngine::playbackFrame() const {
+    return backend_->playedFrames();
+}
+
+void AudioEngine::poll() {
+    uint64_t frame = playbackFrame();
+    clock_.observe(frame, Clock::now());
+}
+
+AudioEngine::Clock::time_point AudioEngine::waitForFrame(uint64_t frame) {
+    for (;;) {
+        poll();
+        Clock::time_point due = clock_.timeOf(frame);
+        Clock::time_point now = Clock::now();
+        if (now >= due) {
+            return due;
+        }
+        // Short sleeps keep the clock estimate fresh as the deadline nears.
+        std::this_thread::sleep_for(std::min<Clock::duration>(due - now, std::chrono::milliseconds(2)));
+    }
+}
+
+uint64_t AudioEngine::cutQueued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t fade = std::min(queue_.size(), static_cast<size_t>(sampleRate_ * CUT_FADE_MS / 1000));
+    for (size_t i = 0; i < fade; ++i) {
+        queue_[i] = static_cast<short>(queue_[i] * static_cast<double>(fade - i) / fade);
+    }
+    queue_.resize(fade);
+    return handedOut_ + queue_.size();
+}
+
+void AudioEngine::setSidetonePitch(float pitch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sidetonePitch_ = pitch;
+}
+
+void AudioEngine::keyEdge(bool down, Clock::time_point when) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingEdges_.push_back({down, when, 0});
+}
+
+std::vector<double> AudioEngine::takeSidetoneLatencies() {
+    std::vector<SidetoneEdge> edges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        edges.swap(renderedEdges_);
+    }
+    std::vector<double> latencies;
+    if (!clock_.valid()) {
+        return latencies;
+    }
+    for (const SidetoneEdge& e : edges) {
+        latencies.push_back(std::chrono::duration<double, std::milli>(
+            clock_.timeOf(e.frame) - e.when).count());
+    }
+    return latencies;
+}
+
+void AudioEngine::setLowLatency(bool on) {
+    backend_->setLowLatency(on);
+}
+
+void AudioEngine::render(short* out, size_t frames) {
+    MorseCore::metrics().audioPeriods.add();
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = std::min(queue_.size(), frames);
+    std::copy(queue_.begin(), queue_.begin() + n, out);
+    queue_.erase(queue_.begin(), queue_.begin() + n);
+    std::fill(out + n, out + frames, 0);
+
+    // Edges waiting since the last period start at its first frame; later
+    // ones keep their distance from the first.
+    if (sidetoneOn_ || !pendingEdges_.empty()) {
+        Clock::time_point base = pendingEdges_.empty() ? Clock::time_point() : pendingEdges_.front().when;
+        double step = 2.0 * 3.14159 * sidetonePitch_ / sampleRate_;
+        for (size_t i = 0; i < frames; ++i) {
+            while (!pendingEdges_.empty()) {
+                SidetoneEdge& e = pendingEdges_.front();
+                auto offset = std::chrono::duration<double>(e.when - base).count() * sampleRate_;
+                if (offset > static_cast<double>(i)) break;
+                sidetoneOn_ = e.down;
+                e.frame = handedOut_ + i;
+                renderedEdges_.push_back(e);
+                pendingEdges_.pop_front();
+            }
+            if (sidetoneOn_) {
+                int mixed = out[i] + static_cast<int>(32767 * std::sin(sidetonePhase_));
+                out[i] = static_cast<short>(std::max(-32768, std::min(32767, mixed)));
+                sidetonePhase_ += step;
+            } else {
+                sidetonePhase_ = 0.0;   // each mark starts at the same phase, as rendered tones do
+            }
+        }
+    }
+    handedOut_ += frames;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "audio_backend.h"
+#include "playback_clock.h"
+
+// ------------------------------------------------------------
+// Continuous output stream over an AudioBackend. Audio is queued
+// as samples and the stream plays silence whenever the queue is
+// empty, so frame numbers form one unbroken timeline from start().
+// Queued audio is addressed by frame number, and PlaybackClock
+// turns the backend's reported position into steady_clock times
+// for those frames.
+// ------------------------------------------------------------
+class AudioEngine {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    AudioEngine(int sampleRate, std::unique_ptr<AudioBackend> backend);
+    ~AudioEngine();
+    AudioEngine(const AudioEngine&) = delete;
+    AudioEngine& operator=(const AudioEngine&) = delete;
+
+    // Starts the backend unless it is running; false if it could not
+    // be opened, with the reason in error().
+    bool start();
+    const std::string& error() const { return backend_->error(); }
+    const char* backendName() const { return backend_->name(); }
+
+    // Appends samples to the output; returns the frame number at
+    // which the first of them will play.
+    uint64_t enqueue(const short* samples, size_t count);
+
+    // Reads the device position and feeds it to the playback clock.
+    void poll();
+
+    // Frame the device reports as playing right now.
+    uint64_t playbackFrame() const;
+
+    // Best estimate of when `frame` leaves the device. Call poll()
+    // (or waitForFrame) first so the estimate is fresh.
+    Clock::time_point timeOfFrame(uint64_t frame) const { return clock_.timeOf(frame); }
+
+    // Sleeps until `frame` has been played, polling the device as it
+    // goes; returns the estimated time the frame left the device.
+    Clock::time_point waitForFrame(uint64_t frame);
+
+    // Drops the audio not yet handed to the device, fading out over the
+    // first few milliseconds of it so the tone does not end in a click.
+    // Returns the frame at which the stream falls silent; what the
+    // device already holds still plays.
+    uint64_t cutQueued();
+
+    int sampleRate() const { return sampleRate_; }
+
+    // Live sidetone, mixed over the queued audio while the key is down.
+    // Edges keep their spacing within a period, so short marks survive.
+    void setSidetonePitch(float pitch);
+    void keyEdge(bool down, Clock::time_point when);
+    // Edge-to-device latencies (ms) of the sidetone changes rendered
+    // since the last call; poll() first so the clock is fresh.
+    std::vector<double> takeSidetoneLatencies();
+    // Short periods, so a key edge waits for a few short periods of
+    // queued audio rather than full ones. Costs more wakeups and less
+    // underrun margin; use it while keying.
+    void setLowLatency(bool on);
+
+private:
+    // The backend's render callback: the next `frames` of the timeline.
+    void render(short* out, size_t frames);
+
+    int sampleRate_;
+    std::unique_ptr<AudioBackend> backend_;
+    std::mutex mutex_;
+    std::deque<short> queue_;
+    uint64_t handedOut_ = 0;  // frames already given to the backend
+    MorseCore::PlaybackClock clock_;
+
+    struct SidetoneEdge {
+        bool down;
+        Clock::time_point when;
+        uint64_t frame;   // set once rendered
+    };
+    float sidetonePitch_ = 800.0f;
+    double sidetonePhase_ = 0.0;
+    bool sidetoneOn_ = false;
+    std::deque<SidetoneEdge> pendingEdges_;
+    std::vector<SidetoneEdge> renderedEdges_;
+};
@@ -0,0 +1,103 @@
+#include "audio_backend.h"
+
+#include <SFML/Audio.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "metrics.h"
+#include "trace.h"
+
+namespace {
+
+// SFML over OpenAL: three queued buffers of one period each, refilled
+// from SFML's streaming thread.
+class SfmlBackend : public AudioBackend {
+public:
+    explicit SfmlBackend(size_t periodFrames) : stream_(periodFrames) {}
+    ~SfmlBackend() override { stop(); }
+
+    bool start(int sampleRate, Render render) override {
+        if (running()) {
+            return true;
+        }
+        sampleRate_ = sampleRate;
+        stream_.render = std::move(render);
+        stream_.open(sampleRate);
+        stream_.play();
+        if (!running()) {
+            error_ = "SFML could not open the sound device";
+            return false;
+        }
+        return true;
+    }
+
+    void stop() override { stream_.stop(); }
+
+    bool running() const override { return stream_.getStatus() == sf::SoundSource::Playing; }
+
+    uint64_t playedFrames() const override {
+        return static_cast<uint64_t>(stream_.getPlayingOffset().asMicroseconds()) * sampleRate_ / 1000000;
+    }
+
+    void setLowLatency(bool on) override {
+        stream_.lowLatency = on;
+        stream_.setProcessingInterval(sf::milliseconds(on ? 1 : 10));
+    }
+
+    const char* name() const override { return "sfml"; }
+
+private:
+    struct Stream : sf::SoundStream {
+        explicit Stream(size_t periodFrames)
+            : periodFrames(periodFrames),
+              buffer(std::max(periodFrames, LOW_LATENCY_PERIOD_FRAMES)) {}
+
+        void open(int rate) {
+            sampleRate = rate;
+            lastFrames = 0;
+            initialize(1, static_cast<unsigned int>(rate));
+        }
+        using sf::SoundStream::setProcessingInterval;
+
+        bool onGetData(Chunk& data) override {
+            size_t frames = lowLatency ? std::min(periodFrames, LOW_LATENCY_PERIOD_FRAMES) : periodFrames;
+            // OpenAL holds three periods; a refill asked for later than
+            // they last means the source ran dry and SFML restarted it.
+            auto now = std::chrono::steady_clock::now();
+            if (lastFrames > 0 && now - lastFill > std::chrono::microseconds(3 * lastFrames * 1000000 / sampleRate)) {
+                MorseCore::metrics().audioUnderruns.add();
+                CW_TRACE_COMPLETE("playback", "late refill", lastFill, now);
+            }
+            lastFill = now;
+            lastFrames = frames;
+            render(buffer.data(), frames);
+            data.samples = buffer.data();
+            data.sampleCount = frames;
+            return true;
+        }
+
+        void onSeek(sf::Time) override {
+            // The stream is a live timeline; seeking has no meaning.
+        }
+
+        size_t periodFrames;
+        std::vector<short> buffer;
+        Render render;
+        std::atomic<bool> lowLatency{false};
+        int sampleRate = 0;
+        std::chrono::steady_clock::time_point lastFill;
+        size_t lastFrames = 0;
+    };
+
+    Stream stream_;
+    int sampleRate_ = 0;
+};
+
+} // namespace
+
+std::unique_ptr<AudioBackend> makeSfmlBackend(const AudioOptions& options) {
+    return std::unique_ptr<AudioBackend>(new SfmlBackend(options.period()));
+}
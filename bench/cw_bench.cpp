@@ -0,0 +1,403 @@
+// Microbenchmarks for the trainer's hot paths.
+//
+// Usage: cw_bench [--filter SUBSTR] [--min-time MS] [--wordlist PATH] [--corpus PATH]
+//
+// Results are printed to stdout as one JSON document so runs can be
+// archived and compared across versions.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "callsign.h"
+#include "copy_grading.h"
+#include "item_catalog.h"
+#include "key_decoder.h"
+#include "metrics.h"
+#include "morse_core.h"
+#include "qso_text.h"
+#include "speed_controller.h"
+#include "trainer_session.h"
+#include "winkeyer_core.h"
+
+#ifndef CW_DEFAULT_WORDLIST
+#define CW_DEFAULT_WORDLIST "wordlist"
+#endif
+#ifndef CW_DEFAULT_QSO_CORPUS
+#define CW_DEFAULT_QSO_CORPUS "qso_corpus"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+volatile uint64_t sink;
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double p50Ns;
+    double p99Ns;
+    std::string unit;      // what "items" counts, e.g. "samples"
+    double itemsPerOp;
+};
+
+struct Options {
+    std::string filter;
+    double minTimeMs = 300.0;
+    std::string wordlist = CW_DEFAULT_WORDLIST;
+    std::string corpus = CW_DEFAULT_QSO_CORPUS;
+};
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+// Runs fn in batches until minTimeMs has elapsed. Each batch is sized
+// to take roughly 20 us so clock overhead stays out of the numbers;
+// per-op latency percentiles are taken over the batches.
+template <typename F>
+Result measure(const std::string& name, const Options& opt,
+               const std::string& unit, double itemsPerOp, F&& fn) {
+    uint64_t batch = 1;
+    for (;;) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (ns >= 20000.0 || batch >= (1u << 24)) break;
+        batch *= 2;
+    }
+
+    std::vector<double> perOp;
+    uint64_t iterations = 0;
+    double totalNs = 0.0;
+    while (totalNs < opt.minTimeMs * 1e6) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        perOp.push_back(ns / batch);
+        iterations += batch;
+        totalNs += ns;
+    }
+
+    Result r;
+    r.name = name;
+    r.iterations = iterations;
+    r.nsPerOp = totalNs / iterations;
+    r.p50Ns = percentile(perOp, 0.50);
+    r.p99Ns = percentile(perOp, 0.99);
+    r.unit = unit;
+    r.itemsPerOp = itemsPerOp;
+    return r;
+}
+
+void printResults(const std::vector<Result>& results) {
+    std::cout << "{\n  \"suite\": \"cw_bench\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        double opsPerSec = 1e9 / r.nsPerOp;
+        std::cout << "    {\"name\": \"" << r.name << "\""
+                  << ", \"iterations\": " << r.iterations
+                  << ", \"ns_per_op\": " << r.nsPerOp
+                  << ", \"p50_ns\": " << r.p50Ns
+                  << ", \"p99_ns\": " << r.p99Ns
+                  << ", \"ops_per_sec\": " << opsPerSec
+                  << ", \"unit\": \"" << r.unit << "\""
+                  << ", \"items_per_sec\": " << opsPerSec * r.itemsPerOp
+                  << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            opt.filter = argv[++i];
+        } else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            opt.minTimeMs = std::atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--wordlist") && i + 1 < argc) {
+            opt.wordlist = argv[++i];
+        } else if (!strcmp(argv[i], "--corpus") && i + 1 < argc) {
+            opt.corpus = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--filter SUBSTR] [--min-time MS] [--wordlist PATH] [--corpus PATH]\n";
+            return 2;
+        }
+    }
+    auto wanted = [&](const char* name) {
+        return opt.filter.empty() || std::string(name).find(opt.filter) != std::string::npos;
+    };
+
+    std::vector<Result> results;
+    std::mt19937 rng(12345);
+
+    if (wanted("tone_synthesis")) {
+        // One 20 WPM dah, the longest single call playBeep makes.
+        MorseCore::Timing t = MorseCore::makeTiming(20, 20);
+        std::vector<short> buf(t.dahSamples);
+        results.push_back(measure("tone_synthesis", opt, "samples", buf.size(), [&] {
+            MorseCore::synthesizeTone(buf.data(), static_cast<int>(buf.size()), 800.0f,
+                                      MorseCore::SAMPLE_RATE);
+            sink = sink + buf[buf.size() / 2];
+        }));
+    }
+
+    if (wanted("message_render")) {
+        const std::string text = "CQ CQ CQ DE KI5BZO KI5BZO K";
+        MorseCore::Timing t = MorseCore::makeTiming(20, 10);
+        std::vector<short> out;
+        size_t samples = MorseCore::messageLength(text, t);
+        results.push_back(measure("message_render", opt, "samples", samples, [&] {
+            sink = sink + MorseCore::renderMessage(text, 800.0f, t, out);
+        }));
+    }
+
+    if (wanted("long_render")) {
+        // Ten minutes of 20 WPM text, sequential and on every core.
+        std::string text;
+        while (text.size() < 10 * 20 * 6) text += "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 1234567890 ";
+        MorseCore::Timing t = MorseCore::makeTiming(20, 20);
+        std::vector<short> out;
+        size_t samples = MorseCore::messageLength(text, t);
+        results.push_back(measure("long_render_sequential", opt, "samples", samples, [&] {
+            sink = sink + MorseCore::renderMessageParallel(text, 800.0f, t, out, 1);
+        }));
+        results.push_back(measure("long_render_parallel", opt, "samples", samples, [&] {
+            sink = sink + MorseCore::renderMessageParallel(text, 800.0f, t, out);
+        }));
+    }
+
+    if (wanted("morse_lookup")) {
+        std::string text;
+        const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,?/= abcdefghijklmnopqrstuvwxyz";
+        for (int i = 0; i < 256; ++i) text.push_back(alphabet[i % (sizeof(alphabet) - 1)]);
+        results.push_back(measure("morse_lookup", opt, "chars", text.size(), [&] {
+            uint64_t acc = 0;
+            for (char c : text) {
+                const char* p = MorseCore::lookup(c);
+                acc += p ? p[0] : 0;
+            }
+            sink = sink + acc;
+        }));
+    }
+
+    std::vector<MorseCore::ItemId> mixedPool = MorseCore::buildPool(MorseCore::Category::Mixed);
+
+    if (wanted("question_sampling")) {
+        std::vector<bool> used;
+        results.push_back(measure("question_sampling", opt, "questions", 1, [&] {
+            if (std::find(used.begin(), used.end(), false) == used.end()) used.clear();
+            sink = sink + MorseCore::sampleQuestion(mixedPool, used, rng);
+        }));
+    }
+
+    if (wanted("spaced_repetition_pick")) {
+        MorseCore::ItemTally misses;
+        for (size_t i = 0; i < mixedPool.size(); ++i) {
+            misses.grow(mixedPool[i]);
+            misses.missed[mixedPool[i]] = static_cast<uint32_t>(i % 7);
+        }
+        results.push_back(measure("spaced_repetition_pick", opt, "questions", 1, [&] {
+            sink = sink + MorseCore::pickWeighted(misses, mixedPool, rng);
+        }));
+    }
+
+    if (wanted("session_question")) {
+        // One full question cycle through the headless API: pick, render
+        // into a caller buffer in 512-sample periods, grade.
+        MorseCore::SessionConfig config;
+        config.pool = mixedPool;
+        config.numQuestions = 1 << 30;
+        config.seed = 1;
+        MorseCore::Session session(config);
+        std::vector<short> period(512);
+        results.push_back(measure("session_question", opt, "questions", 1, [&] {
+            session.nextQuestion();
+            size_t total = 0, n;
+            while ((n = session.renderAudio(period.data(), period.size())) > 0) total += n;
+            sink = sink + total + session.submitAnswer("E").correct;
+        }));
+    }
+
+    if (wanted("session_answer")) {
+        // The bookkeeping around one answer, without the audio: weighted
+        // pick, grading and the session and all-time counts.
+        MorseCore::SessionConfig config;
+        config.pool = mixedPool;
+        config.numQuestions = 1 << 30;
+        config.selection = MorseCore::Selection::Weighted;
+        config.seed = 1;
+        MorseCore::ItemTally misses;
+        MorseCore::Session session(config, &misses);
+        results.push_back(measure("session_answer", opt, "answers", 1, [&] {
+            session.nextQuestion();
+            sink = sink + session.submitAnswer("E").correct;
+        }));
+    }
+
+    std::vector<std::string> words = MorseCore::loadWordlist(opt.wordlist);
+    if (words.empty() && (wanted("wordlist_load") || wanted("wordlist_filter"))) {
+        std::cerr << "warning: could not read '" << opt.wordlist
+                  << "', skipping word list benchmarks\n";
+    } else {
+        if (wanted("wordlist_load")) {
+            results.push_back(measure("wordlist_load", opt, "words", words.size(), [&] {
+                sink = sink + MorseCore::loadWordlist(opt.wordlist).size();
+            }));
+        }
+        if (wanted("wordlist_filter")) {
+            results.push_back(measure("wordlist_filter", opt, "words", words.size(), [&] {
+                sink = sink + MorseCore::filterWords(words, 4, true).size();
+            }));
+        }
+    }
+
+    if (wanted("winkeyer_parse")) {
+        // Mostly echo characters with pot and status bytes mixed in,
+        // roughly what a busy practice session produces.
+        std::vector<unsigned char> stream(4096);
+        for (size_t i = 0; i < stream.size(); ++i) {
+            if (i % 64 == 0)      stream[i] = static_cast<unsigned char>(0x80 | (i / 64 % 32));
+            else if (i % 97 == 0) stream[i] = 0xC0;
+            else                  stream[i] = static_cast<unsigned char>('A' + i % 26);
+        }
+        results.push_back(measure("winkeyer_parse", opt, "bytes", stream.size(), [&] {
+            uint64_t acc = 0;
+            for (unsigned char b : stream) {
+                switch (WinKeyerCore::classify(b)) {
+                case WinKeyerCore::ByteKind::SpeedPot: acc += WinKeyerCore::potToWpm(b, 5, 35); break;
+                case WinKeyerCore::ByteKind::Status:   acc += 1; break;
+                case WinKeyerCore::ByteKind::Echo:     acc += b; break;
+                }
+            }
+            sink = sink + acc;
+        }));
+    }
+
+    if (wanted("key_decode")) {
+        // A straight-keyed "PARIS " stream at 20 WPM with a little
+        // timing jitter, as the serial key input would deliver it.
+        std::vector<MorseCore::KeyEdge> edges;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> jitter(0.85, 1.15);
+        auto t = Clock::time_point();
+        auto advance = [&](double dits) {
+            t += std::chrono::microseconds(static_cast<long long>(dits * 60000 * jitter(rng)));
+        };
+        std::string text = "PARIS PARIS PARIS PARIS ";
+        for (char c : text) {
+            if (c == ' ') { advance(4); continue; }
+            std::string pattern = MorseCore::lookup(c);
+            for (size_t i = 0; i < pattern.size(); ++i) {
+                edges.push_back({true, t});
+                advance(pattern[i] == '-' ? 3 : 1);
+                edges.push_back({false, t});
+                advance(i + 1 < pattern.size() ? 1 : 3);
+            }
+        }
+        results.push_back(measure("key_decode", opt, "edges", edges.size(), [&] {
+            MorseCore::KeyDecoder decoder(20);
+            size_t chars = 0;
+            for (const MorseCore::KeyEdge& e : edges) {
+                chars += decoder.addEdge(e).size();
+            }
+            chars += decoder.flush(t + std::chrono::seconds(1)).size();
+            sink = sink + chars;
+        }));
+    }
+
+    if (wanted("callsign_generate")) {
+        // Pileup simulation and bulk export draw calls back to back.
+        MorseCore::CallsignGenerator generator(1);
+        char call[MorseCore::CallsignGenerator::MAX_LENGTH];
+        const size_t batch = 1000;
+        results.push_back(measure("callsign_generate", opt, "calls", batch, [&] {
+            size_t chars = 0;
+            for (size_t i = 0; i < batch; ++i) {
+                chars += generator.next(call);
+            }
+            sink = sink + chars + call[0];
+        }));
+    }
+
+    if (wanted("qso_generate")) {
+        MorseCore::QsoModel model;
+        if (!model.load(opt.corpus)) {
+            std::cerr << "warning: " << model.error() << ", skipping qso_generate\n";
+        } else {
+            MorseCore::QsoGenerator generator(model, 1);
+            results.push_back(measure("qso_generate", opt, "qsos", 1, [&] {
+                sink = sink + generator.nextQso().size();
+            }));
+        }
+    }
+
+    if (wanted("copy_grade")) {
+        // A 10,000-character copy with about one character in twenty
+        // wrong, dropped or added.
+        std::mt19937 rng(7);
+        std::string sent;
+        while (sent.size() < 10000) sent += "CQ CQ DE W1AW W1AW K RST 599 NAME BOB QTH BOSTON ";
+        std::string typed = sent;
+        for (int i = 0; i < 500; ++i) {
+            size_t at = rng() % typed.size();
+            switch (rng() % 3) {
+                case 0: typed[at] = 'E'; break;
+                case 1: typed.erase(at, 1); break;
+                default: typed.insert(at, 1, 'T'); break;
+            }
+        }
+        results.push_back(measure("copy_grade", opt, "chars", sent.size(), [&] {
+            sink = sink + MorseCore::gradeCopy(sent, typed).errors.size();
+        }));
+    }
+
+    if (wanted("speed_controller")) {
+        // One adaptive session's worth of answers, 90% right.
+        const size_t answers = 1000;
+        results.push_back(measure("speed_controller", opt, "answers", answers, [&] {
+            MorseCore::SpeedController speed(MorseCore::SpeedControllerConfig{});
+            for (size_t i = 0; i < answers; ++i) {
+                speed.record(i % 10 != 3, 0.8 + 0.001 * static_cast<double>(i % 700));
+            }
+            sink = sink + speed.wpm();
+        }));
+    }
+
+    if (wanted("metrics")) {
+        // What an event costs when nobody is scraping: a counter bump
+        // and a histogram observation, as at every keyer byte.
+        const size_t events = 100000;
+        MorseCore::Metrics& m = MorseCore::metrics();
+        results.push_back(measure("metrics", opt, "events", events, [&] {
+            for (size_t i = 0; i < events; ++i) {
+                m.winkeyerBytesIn.add();
+                m.inputToScreen.observe(0.0001 * static_cast<double>(i % 64));
+            }
+            sink = sink + m.winkeyerBytesIn.value();
+        }));
+    }
+
+    if (wanted("metrics_format")) {
+        // One scrape.
+        results.push_back(measure("metrics_format", opt, "scrapes", 1, [&] {
+            sink = sink + MorseCore::formatMetrics(MorseCore::metrics()).size();
+        }));
+    }
+
+    printResults(results);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "callsign.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+// A prefix pattern is written out character by character:
+//   '#' any digit, '@' any letter, '%' the second letter of a US
+//   two-letter prefix (not H, L or P, which belong to the territories),
+//   '^' A-L (the US A-prefixes); anything else is copied as is.
+// suffixLengths lists the suffix lengths the country issues; a length
+// listed twice is drawn twice as often. weight is the share of calls
+// heard on the air, per mille of the whole table.
+struct PrefixRule {
+    const char* pattern;
+    unsigned weight;
+    const char* suffixLengths;
+};
+
+const PrefixRule prefixRules[] = {
+    // North America
+    {"K#", 70, "23333"}, {"W#", 60, "23333"}, {"N#", 35, "3"},
+    {"K%#", 45, "3"}, {"W%#", 25, "3"}, {"N%#", 15, "3"}, {"A^#", 20, "12"},
+    {"KH6", 3, "23"}, {"KL7", 2, "23"}, {"KP4", 2, "23"},
+    {"VE#", 12, "23"}, {"VA#", 6, "3"}, {"XE#", 3, "23"},
+    // Europe
+    {"DL#", 40, "233"}, {"DK#", 12, "233"}, {"DJ#", 10, "23"}, {"DF#", 6, "233"}, {"DG#", 4, "3"},
+    {"G#", 25, "3"}, {"M#", 10, "3"}, {"F#", 15, "3"}, {"ON#", 6, "23"},
+    {"PA#", 10, "23"}, {"PD#", 3, "3"}, {"I#", 12, "23"}, {"IK#", 10, "3"}, {"IZ#", 8, "3"},
+    {"EA#", 20, "23"}, {"CT#", 3, "23"}, {"HB9", 6, "23"}, {"OE#", 5, "23"},
+    {"OK#", 8, "23"}, {"OM#", 4, "23"}, {"SP#", 12, "23"}, {"SQ#", 4, "3"},
+    {"HA#", 6, "23"}, {"YO#", 5, "23"}, {"LZ#", 4, "23"}, {"S5#", 3, "23"},
+    {"9A#", 4, "23"}, {"YU#", 3, "23"}, {"SV#", 3, "23"}, {"OH#", 6, "23"},
+    {"SM#", 8, "23"}, {"LA#", 4, "23"}, {"OZ#", 5, "23"}, {"EI#", 2, "23"},
+    {"UA#", 20, "23"}, {"RA#", 6, "3"}, {"RW#", 3, "23"}, {"RU#", 3, "3"},
+    {"UR#", 6, "23"}, {"UT#", 3, "3"}, {"LY#", 2, "23"}, {"YL#", 2, "23"},
+    {"ES#", 2, "23"}, {"EW#", 2, "23"}, {"TA#", 2, "23"}, {"4X#", 2, "23"},
+    // Asia
+    {"JA#", 25, "23"}, {"JH#", 8, "3"}, {"JR#", 6, "3"}, {"JE#", 4, "3"}, {"7K#", 3, "3"},
+    {"BY#", 4, "23"}, {"BA#", 3, "3"}, {"BG#", 3, "3"}, {"BV#", 2, "23"},
+    {"HL#", 4, "23"}, {"DS#", 2, "3"}, {"VU#", 3, "23"}, {"YB#", 4, "23"},
+    {"DU#", 2, "23"}, {"9M2", 1, "23"}, {"HS0", 1, "23"}, {"UN#", 1, "23"}, {"A6#", 1, "23"},
+    // South America
+    {"PY#", 8, "23"}, {"PU#", 2, "3"}, {"LU#", 5, "23"}, {"CE#", 2, "23"},
+    {"CX#", 2, "23"}, {"HK#", 2, "23"}, {"YV#", 2, "23"}, {"OA#", 1, "23"},
+    {"CO#", 1, "23"}, {"HI8", 1, "23"}, {"TI#", 1, "23"},
+    // Oceania and Africa
+    {"VK#", 8, "23"}, {"ZL#", 4, "23"}, {"ZS#", 3, "23"}, {"5B4", 2, "23"},
+    {"CN8", 1, "23"}, {"SU#", 1, "23"}, {"EA8", 3, "23"}, {"EA6", 1, "23"},
+    {"CT3", 1, "23"}, {"5Z4", 1, "23"}, {"9J2", 1, "23"},
+};
+
+// Where a station signs "prefix/call" from, weighted the same way.
+const PrefixRule portablePrefixes[] = {
+    {"EA8", 6, ""}, {"F", 4, ""}, {"DL", 4, ""}, {"G", 3, ""}, {"I", 3, ""},
+    {"EA", 3, ""}, {"VE#", 2, ""}, {"W#", 2, ""}, {"KH6", 2, ""}, {"VP2E", 1, ""},
+    {"FG", 1, ""}, {"PJ2", 1, ""}, {"ZF", 1, ""}, {"C6A", 1, ""},
+};
+
+// Trailing portable designators, per mille of all calls; whatever is
+// left over goes out plain.
+struct Designator {
+    const char* text;
+    unsigned perMille;
+};
+
+const Designator designators[] = {
+    {"/P", 30}, {"/#", 12}, {"/M", 8}, {"/QRP", 4}, {"/MM", 1},
+};
+
+const unsigned PREFIX_PORTABLE_PER_MILLE = 15;
+
+// Cumulative weights so a draw is one binary search.
+template <size_t N>
+struct WeightTable {
+    unsigned cumulative[N];
+    unsigned total = 0;
+    explicit WeightTable(const PrefixRule (&rules)[N]) {
+        for (size_t i = 0; i < N; ++i) {
+            total += rules[i].weight;
+            cumulative[i] = total;
+        }
+    }
+    size_t pick(uint32_t r) const {   // r in [0, total)
+        return std::upper_bound(cumulative, cumulative + N, r) - cumulative;
+    }
+};
+
+const auto& prefixWeights() {
+    static const WeightTable<sizeof(prefixRules) / sizeof(prefixRules[0])> table(prefixRules);
+    return table;
+}
+
+const auto& portableWeights() {
+    static const WeightTable<sizeof(portablePrefixes) / sizeof(portablePrefixes[0])> table(portablePrefixes);
+    return table;
+}
+
+} // namespace
+
+CallsignGenerator::CallsignGenerator(uint64_t seed) : state_(seed) {}
+
+// splitmix64: one add and three multiply-xorshifts per draw, several
+// times cheaper than std::mt19937 and plenty for picking letters.
+uint32_t CallsignGenerator::random() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+}
+
+uint32_t CallsignGenerator::below(uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(random()) * n) >> 32);
+}
+
+bool CallsignGenerator::chance(uint32_t perMille) {
+    return below(1000) < perMille;
+}
+
+namespace {
+
+// Expands a prefix pattern at out, returns the number of characters.
+template <typename Draw>
+size_t expandPattern(const char* pattern, char* out, Draw&& below) {
+    static const char usSecond[] = "ABCDEFGIJKMNOQRSTUVWXYZ";   // no H, L, P
+    size_t n = 0;
+    for (const char* p = pattern; *p; ++p) {
+        switch (*p) {
+            case '#': out[n++] = static_cast<char>('0' + below(10)); break;
+            case '@': out[n++] = static_cast<char>('A' + below(26)); break;
+            case '%': out[n++] = usSecond[below(sizeof(usSecond) - 1)]; break;
+            case '^': out[n++] = static_cast<char>('A' + below(12)); break;
+            default:  out[n++] = *p; break;
+        }
+    }
+    return n;
+}
+
+} // namespace
+
+size_t CallsignGenerator::next(char* out) {
+    auto draw = [this](uint32_t n) { return below(n); };
+    size_t n = 0;
+
+    if (chance(PREFIX_PORTABLE_PER_MILLE)) {
+        const auto& weights = portableWeights();
+        n += expandPattern(portablePrefixes[weights.pick(below(weights.total))].pattern, out, draw);
+        out[n++] = '/';
+    }
+
+    const auto& weights = prefixWeights();
+    const PrefixRule& rule = prefixRules[weights.pick(below(weights.total))];
+    n += expandPattern(rule.pattern, out + n, draw);
+
+    // Suffixes never start with Q, which would read as a Q code.
+    size_t lengths = std::strlen(rule.suffixLengths);
+    int suffix = rule.suffixLengths[below(static_cast<uint32_t>(lengths))] - '0';
+    uint32_t first = below(25);
+    out[n++] = static_cast<char>('A' + first + (first >= 'Q' - 'A' ? 1 : 0));
+    for (int i = 1; i < suffix; ++i) {
+        out[n++] = static_cast<char>('A' + below(26));
+    }
+
+    uint32_t roll = below(1000);
+    for (const Designator& d : designators) {
+        if (roll >= d.perMille) {
+            roll -= d.perMille;
+            continue;
+        }
+        n += expandPattern(d.text, out + n, draw);
+        break;
+    }
+    return n;
+}
+
+std::string CallsignGenerator::next() {
+    char buffer[MAX_LENGTH];
+    return std::string(buffer, next(buffer));
+}
+
+std::vector<std::string> generateCallsigns(size_t count, uint64_t seed) {
+    CW_TRACE_SPAN("select", "generateCallsigns");
+    CallsignGenerator generator(seed);
+    std::vector<std::string> calls;
+    std::unordered_set<std::string> seen;
+    calls.reserve(count);
+    // The space of calls is vast, so the retry bound only guards
+    // against a pathological seed.
+    for (size_t tries = 0; calls.size() < count && tries < count * 4; ++tries) {
+        std::string call = generator.next();
+        if (seen.insert(call).second) {
+            calls.push_back(std::move(call));
+        }
+    }
+    return calls;
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Realistic amateur callsigns for copy practice. Prefixes are
+// drawn in proportion to how often each country is heard on the
+// air, then a call area digit and a suffix of the shapes that
+// country actually issues (1x2, 2x3, ...), with the occasional
+// /P, /M, /QRP or prefix/ portable form. Generation is allocation
+// free and fully determined by the seed.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+class CallsignGenerator {
+public:
+    // Longest call written by next(char*), e.g. "VP2E/KA1ABC/QRP".
+    static const size_t MAX_LENGTH = 24;
+
+    explicit CallsignGenerator(uint64_t seed);
+
+    // Writes the next call to out (at least MAX_LENGTH bytes, not
+    // NUL-terminated) and returns its length.
+    size_t next(char* out);
+
+    std::string next();
+
+private:
+    uint32_t random();
+    uint32_t below(uint32_t n);   // uniform in [0, n)
+    bool chance(uint32_t perMille);
+
+    uint64_t state_;
+};
+
+// count calls from one generator; duplicates are dropped, so a
+// practice pool never asks the same call twice.
+std::vector<std::string> generateCallsigns(size_t count, uint64_t seed);
+
+} // end namespace MorseCore
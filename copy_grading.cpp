@@ -0,0 +1,317 @@
+#include "copy_grading.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <unordered_map>
+
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+using Word = uint64_t;
+const size_t WORD_BITS = 64;
+const Word HIGH_BIT = Word(1) << (WORD_BITS - 1);
+
+// Advances one block of 64 rows by one text symbol. pv/mv hold the
+// block's vertical deltas (+1/-1 per row), eq the rows whose pattern
+// symbol matches; hin is the horizontal delta coming in at the top
+// row. Returns the horizontal delta going out at the bottom row.
+int advanceBlock(Word& pv, Word& mv, Word eq, int hin) {
+    Word hinNeg = hin < 0 ? 1 : 0;
+    Word xv = eq | mv;
+    eq |= hinNeg;
+    Word xh = (((eq & pv) + pv) ^ pv) | eq;
+    Word ph = mv | ~(xh | pv);
+    Word mh = pv & xh;
+    int hout = (ph & HIGH_BIT) ? 1 : (mh & HIGH_BIT) ? -1 : 0;
+    ph = (ph << 1) | (hin > 0 ? 1 : 0);
+    mh = (mh << 1) | hinNeg;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+// Value of the row `bits` rows into a block whose top row holds `top`.
+size_t blockValue(size_t top, Word pv, Word mv, size_t bits) {
+    Word mask = bits >= WORD_BITS ? ~Word(0) : (Word(1) << bits) - 1;
+    return top + __builtin_popcountll(pv & mask) - __builtin_popcountll(mv & mask);
+}
+
+// Global edit distance between a pattern (the table's rows) and a
+// text (its columns), both as dense symbol ids below `alphabet`; a
+// text id of `alphabet` matches nothing.
+//
+// Only a band of blocks is computed (Ukkonen): a cell worth at most k
+// lies within k of the diagonal, so each column needs just the blocks
+// covering rows j-k..j+k. Cells at the band's edges are treated as one
+// more than their neighbour, which can only overstate them, so every
+// cell worth at most k still comes out exact. The band starts narrow
+// and doubles until the distance fits, which makes good copy cheap
+// however long it is.
+//
+// With keep set, each column's vertical deltas are kept, which is all
+// a traceback needs: any cell is its block's top value plus a popcount.
+class Aligner {
+public:
+    Aligner(const std::vector<uint32_t>& pattern, size_t alphabet)
+        : rows_(pattern.size()), blocks_((pattern.size() + WORD_BITS - 1) / WORD_BITS),
+          peq_((alphabet + 1) * blocks_, 0) {
+        for (size_t i = 0; i < rows_; ++i) {
+            peq_[pattern[i] * blocks_ + i / WORD_BITS] |= Word(1) << (i % WORD_BITS);
+        }
+    }
+
+    size_t run(const std::vector<uint32_t>& text, bool keep) {
+        size_t longest = std::max(rows_, text.size());
+        for (size_t k = WORD_BITS;; k *= 2) {
+            size_t d = runBanded(text, std::min(k, longest), false);
+            if (d <= k || k >= longest) {
+                // Once the distance is known the band can be exactly
+                // that wide for the pass that keeps its columns.
+                if (keep) runBanded(text, d, true);
+                return d;
+            }
+        }
+    }
+
+    // Cell (i, j) of a kept table: i pattern rows against j text
+    // columns. Cells outside the band read as unreachable.
+    size_t cell(size_t i, size_t j) const {
+        if (j == 0) return i;
+        if (i == 0) return j;
+        size_t b = (i - 1) / WORD_BITS;
+        const Column& col = columns_[j - 1];
+        if (b < col.first || b >= col.first + col.count) return UNREACHABLE;
+        size_t k = col.offset + (b - col.first);
+        return blockValue(tops_[k], pvs_[k], mvs_[k], i - b * WORD_BITS);
+    }
+
+private:
+    static constexpr size_t UNREACHABLE = ~size_t(0) / 4;
+
+    struct Column {
+        size_t first;    // first block computed
+        size_t count;
+        size_t offset;   // into pvs_, mvs_ and tops_
+    };
+
+    size_t runBanded(const std::vector<uint32_t>& text, size_t k, bool keep) {
+        const size_t cols = text.size();
+        if (rows_ == 0) return cols;
+        if (cols == 0) return rows_;
+        std::vector<Word> pv(blocks_, ~Word(0));
+        std::vector<Word> mv(blocks_, 0);
+        std::vector<size_t> bottom(blocks_);   // value at each block's last row
+        if (keep) {
+            size_t band = std::min(blocks_, 2 * k / WORD_BITS + 2);
+            columns_.clear();
+            columns_.reserve(cols);
+            pvs_.clear();
+            pvs_.reserve(cols * band);
+            mvs_.clear();
+            mvs_.reserve(cols * band);
+            tops_.clear();
+            tops_.reserve(cols * band);
+        }
+        size_t first = 0;
+        size_t last = std::min(blocks_ - 1, (k > 0 ? k - 1 : 0) / WORD_BITS);
+        for (size_t b = 0; b <= last; ++b) bottom[b] = (b + 1) * WORD_BITS;
+        size_t firstTop = 0;   // value at the row above block `first`
+        for (size_t j = 1; j <= cols; ++j) {
+            size_t wantFirst = j > k + 1 ? (j - k - 1) / WORD_BITS : 0;
+            size_t wantLast = std::min(blocks_ - 1, (j + k - 1) / WORD_BITS);
+            while (last < wantLast) {
+                ++last;
+                pv[last] = ~Word(0);
+                mv[last] = 0;
+                bottom[last] = bottom[last - 1] + WORD_BITS;
+            }
+            if (wantFirst > first) {
+                firstTop = bottom[wantFirst - 1];
+                first = wantFirst;
+            }
+            ++firstTop;   // the row above the band: one more than last column
+            const Word* eq = &peq_[text[j - 1] * blocks_];
+            int h = 1;
+            for (size_t b = first; b <= last; ++b) {
+                h = advanceBlock(pv[b], mv[b], eq[b], h);
+                bottom[b] += h;
+            }
+            if (keep) {
+                size_t offset = pvs_.size();
+                size_t count = last - first + 1;
+                columns_.push_back({first, count, offset});
+                pvs_.resize(offset + count);
+                mvs_.resize(offset + count);
+                tops_.resize(offset + count);
+                tops_[offset] = static_cast<uint32_t>(firstTop);
+                for (size_t b = first; b <= last; ++b, ++offset) {
+                    pvs_[offset] = pv[b];
+                    mvs_[offset] = mv[b];
+                    if (b > first) tops_[offset] = static_cast<uint32_t>(bottom[b - 1]);
+                }
+            }
+        }
+        size_t b = blocks_ - 1;
+        if (last != b || first > b) return UNREACHABLE;
+        size_t top = b == first ? firstTop : bottom[b - 1];
+        return blockValue(top, pv[b], mv[b], rows_ - b * WORD_BITS);
+    }
+
+    size_t rows_;
+    size_t blocks_;
+    std::vector<Word> peq_;        // per symbol, per block: matching rows
+    std::vector<Column> columns_;
+    std::vector<Word> pvs_;        // per column, per computed block
+    std::vector<Word> mvs_;
+    std::vector<uint32_t> tops_;   // value at the row above each block
+};
+
+// Numbers the symbols of the pattern densely; text symbols the pattern
+// never uses all get the one id past them.
+template <typename Symbol>
+size_t denseIds(const std::vector<Symbol>& pattern, const std::vector<Symbol>& text,
+                std::vector<uint32_t>& patternIds, std::vector<uint32_t>& textIds) {
+    std::unordered_map<Symbol, uint32_t> ids;
+    patternIds.clear();
+    for (const Symbol& s : pattern) {
+        auto it = ids.emplace(s, static_cast<uint32_t>(ids.size())).first;
+        patternIds.push_back(it->second);
+    }
+    const uint32_t unused = static_cast<uint32_t>(ids.size());
+    textIds.clear();
+    for (const Symbol& s : text) {
+        auto it = ids.find(s);
+        textIds.push_back(it == ids.end() ? unused : it->second);
+    }
+    return ids.size();
+}
+
+std::vector<std::string> splitWords(const std::string& normalized) {
+    std::vector<std::string> words;
+    size_t start = 0;
+    while (start < normalized.size()) {
+        size_t end = normalized.find(' ', start);
+        if (end == std::string::npos) end = normalized.size();
+        words.push_back(normalized.substr(start, end - start));
+        start = end + 1;
+    }
+    return words;
+}
+
+std::string charName(char c) {
+    return c == ' ' ? std::string("a space") : std::string(1, c);
+}
+
+} // namespace
+
+double CopyGrade::charErrorRate() const {
+    if (sent.empty()) return typed.empty() ? 0.0 : 100.0;
+    return 100.0 * charErrors / sent.size();
+}
+
+double CopyGrade::wordErrorRate() const {
+    if (words == 0) return typed.empty() ? 0.0 : 100.0;
+    return 100.0 * wordErrors / words;
+}
+
+std::string normalizeCopy(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    bool space = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !out.empty();
+            continue;
+        }
+        if (space) out += ' ';
+        space = false;
+        out += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+size_t editDistance(const std::string& a, const std::string& b) {
+    std::vector<uint32_t> pattern, text;
+    size_t alphabet = denseIds(std::vector<char>(a.begin(), a.end()),
+                               std::vector<char>(b.begin(), b.end()), pattern, text);
+    return Aligner(pattern, alphabet).run(text, false);
+}
+
+CopyGrade gradeCopy(const std::string& sent, const std::string& typed) {
+    CW_TRACE_SPAN("grade", "gradeCopy");
+    CopyGrade grade;
+    grade.sent = normalizeCopy(sent);
+    grade.typed = normalizeCopy(typed);
+
+    std::vector<uint32_t> p, t;
+    size_t alphabet = denseIds(std::vector<char>(grade.sent.begin(), grade.sent.end()),
+                               std::vector<char>(grade.typed.begin(), grade.typed.end()), p, t);
+    Aligner aligner(p, alphabet);
+    grade.charErrors = aligner.run(t, true);
+
+    // Walk back from the corner, preferring the diagonal, so a wrong
+    // letter reads as one substitution rather than a miss and an extra.
+    size_t i = p.size();
+    size_t j = t.size();
+    while (i > 0 || j > 0) {
+        size_t here = aligner.cell(i, j);
+        if (i > 0 && j > 0 && aligner.cell(i - 1, j - 1) + (p[i - 1] != t[j - 1]) == here) {
+            if (p[i - 1] != t[j - 1])
+                grade.errors.push_back({CopyError::Substitution, i - 1, grade.sent[i - 1], grade.typed[j - 1]});
+            --i;
+            --j;
+        } else if (i > 0 && aligner.cell(i - 1, j) + 1 == here) {
+            grade.errors.push_back({CopyError::Deletion, i - 1, grade.sent[i - 1], 0});
+            --i;
+        } else {
+            grade.errors.push_back({CopyError::Insertion, i, 0, grade.typed[j - 1]});
+            --j;
+        }
+    }
+    std::reverse(grade.errors.begin(), grade.errors.end());
+
+    std::vector<std::string> sentWords = splitWords(grade.sent);
+    std::vector<std::string> typedWords = splitWords(grade.typed);
+    std::vector<uint32_t> pw, tw;
+    size_t vocabulary = denseIds(sentWords, typedWords, pw, tw);
+    grade.words = sentWords.size();
+    grade.wordErrors = Aligner(pw, vocabulary).run(tw, false);
+    return grade;
+}
+
+std::string describeCopyError(const CopyGrade& grade, const CopyError& error) {
+    std::string what;
+    switch (error.kind) {
+        case CopyError::Substitution:
+            what = "sent " + charName(error.sent) + ", typed " + charName(error.typed);
+            break;
+        case CopyError::Deletion:
+            what = "missed " + charName(error.sent);
+            break;
+        case CopyError::Insertion:
+            what = "extra " + charName(error.typed);
+            break;
+    }
+    // The sent word the error falls in, or the ones either side of a gap.
+    const std::string& s = grade.sent;
+    size_t pos = std::min(error.position, s.size());
+    size_t start = pos;
+    while (start > 0 && s[start - 1] != ' ') --start;
+    size_t end = pos;
+    while (end < s.size() && s[end] != ' ') ++end;
+    if (start == end) {
+        // On a space: take in the word on each side.
+        if (start > 0) --start;
+        while (start > 0 && s[start - 1] != ' ') --start;
+        if (end < s.size()) ++end;
+        while (end < s.size() && s[end] != ' ') ++end;
+    }
+    if (end > start) what += " in \"" + s.substr(start, end - start) + "\"";
+    return what;
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Copy grading. A student's typed transcript is aligned to the text
+// that was sent, so one dropped letter in a long copy costs one
+// error instead of the whole copy. The edit distance comes from
+// Myers' bit-parallel algorithm in Hyyro's block form: each machine
+// word carries 64 rows of the dynamic-programming column, so a
+// 10,000-character session grades in a few milliseconds.
+//
+// Both texts are compared upper-cased with whitespace runs taken as
+// a single space, the way copy is written down.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+struct CopyError {
+    enum Kind { Substitution, Insertion, Deletion };
+    Kind kind;
+    size_t position;   // in the normalized sent text
+    char sent;         // 0 for an insertion
+    char typed;        // 0 for a deletion
+};
+
+struct CopyGrade {
+    std::string sent;          // normalized
+    std::string typed;         // normalized
+    size_t charErrors = 0;     // edit distance
+    size_t words = 0;          // in the sent text
+    size_t wordErrors = 0;     // edit distance over whole words
+    std::vector<CopyError> errors;   // in sent-text order
+
+    // Errors per sent character or word, as a percentage.
+    double charErrorRate() const;
+    double wordErrorRate() const;
+};
+
+std::string normalizeCopy(const std::string& text);
+
+// Levenshtein distance; distance only, no alignment kept.
+size_t editDistance(const std::string& a, const std::string& b);
+
+CopyGrade gradeCopy(const std::string& sent, const std::string& typed);
+
+// "sent E, typed I" / "missed E" / "extra I", with the sent text
+// around it for context.
+std::string describeCopyError(const CopyGrade& grade, const CopyError& error);
+
+} // end namespace MorseCore
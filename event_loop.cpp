@@ -0,0 +1,119 @@
+#include "event_loop.h"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace {
+
+struct itimerspec deadlineSpec(EventLoop::Clock::time_point deadline) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline.time_since_epoch()).count();
+    // An all-zero it_value would disarm the timer; a deadline at or
+    // before the epoch just needs to be in the past.
+    if (ns <= 0) ns = 1;
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+    return spec;
+}
+
+} // namespace
+
+EventLoop::EventLoop() {
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+}
+
+EventLoop::~EventLoop() {
+    for (auto &t : timers_) {
+        close(t.first);
+    }
+    if (epfd_ >= 0) close(epfd_);
+}
+
+bool EventLoop::watch(int fd, FdCallback cb, uint32_t events) {
+    struct epoll_event ev = {};
+    ev.events = events ? events : EPOLLIN;
+    ev.data.fd = fd;
+    int op = fds_.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epfd_, op, fd, &ev) != 0) {
+        return false;
+    }
+    fds_[fd] = std::move(cb);
+    return true;
+}
+
+void EventLoop::unwatch(int fd) {
+    if (fds_.erase(fd)) {
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+EventLoop::TimerId EventLoop::addTimer(Clock::time_point deadline, TimerCallback cb) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        return -1;
+    }
+    struct itimerspec spec = deadlineSpec(deadline);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = tfd;
+    if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0 ||
+        epoll_ctl(epfd_, EPOLL_CTL_ADD, tfd, &ev) != 0) {
+        close(tfd);
+        return -1;
+    }
+    timers_[tfd] = std::move(cb);
+    return tfd;
+}
+
+bool EventLoop::rearmTimer(TimerId id, Clock::time_point deadline) {
+    if (!timers_.count(id)) return false;
+    struct itimerspec spec = deadlineSpec(deadline);
+    return timerfd_settime(id, TFD_TIMER_ABSTIME, &spec, nullptr) == 0;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+    if (timers_.erase(id)) {
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, id, nullptr);
+        close(id);
+    }
+}
+
+void EventLoop::run() {
+    stopped_ = false;
+    while (!stopped_) {
+        runOnce(-1);
+    }
+}
+
+void EventLoop::runOnce(int timeoutMs) {
+    struct epoll_event events[16];
+    int n = epoll_wait(epfd_, events, 16, timeoutMs);
+    if (n < 0) {
+        if (errno == EINTR) return;   // e.g. SIGINT; the caller checks its flags
+        stopped_ = true;
+        return;
+    }
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        auto t = timers_.find(fd);
+        if (t != timers_.end()) {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;   // re-armed or cancelled since epoll_wait returned
+            }
+            TimerCallback cb = std::move(t->second);
+            cancelTimer(fd);
+            cb();
+            continue;
+        }
+        auto f = fds_.find(fd);
+        if (f != fds_.end()) {
+            FdCallback cb = f->second;
+            cb(events[i].events);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+
+// ------------------------------------------------------------
+// Single-threaded epoll loop with timerfd deadlines. Timed modes
+// register their input fds and a deadline; the loop sleeps in
+// epoll_wait until one of them fires, so nothing polls and an
+// expired question is noticed at the deadline itself.
+// ------------------------------------------------------------
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;   // CLOCK_MONOTONIC on Linux
+    using FdCallback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using TimerId = int;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Calls cb whenever fd is readable (or events, if given).
+    bool watch(int fd, FdCallback cb, uint32_t events = 0);
+    void unwatch(int fd);
+
+    // One-shot timer at an absolute deadline. Returns -1 on failure.
+    // A timer is released once it fires, so forget its id then.
+    TimerId addTimer(Clock::time_point deadline, TimerCallback cb);
+    // Moves a pending timer to a new deadline.
+    bool rearmTimer(TimerId id, Clock::time_point deadline);
+    void cancelTimer(TimerId id);
+
+    // Dispatches events until stop() is called.
+    void run();
+    // Waits up to timeoutMs (-1 = forever) and dispatches one batch.
+    void runOnce(int timeoutMs = -1);
+    void stop() { stopped_ = true; }
+    bool stopped() const { return stopped_; }
+
+private:
+    int epfd_;
+    bool stopped_ = false;
+    std::map<int, FdCallback> fds_;
+    std::map<int, TimerCallback> timers_;
+};
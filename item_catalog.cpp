@@ -0,0 +1,219 @@
+#include "item_catalog.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#include "callsign.h"
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+const std::vector<char> punctuationChars = {
+    '.', ',', '?', '!', '-', '/', '(', ')',
+    ':', ';', '=', '+', '\"', '\'', '&', '_', '@'
+};
+
+std::string fold(const std::string& text) {
+    std::string folded = text;
+    for (char &c : folded) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return folded;
+}
+
+ItemKind kindOf(const std::string& text) {
+    if (text.size() == 1) return ItemKind::Character;
+    if (prosigns().count(text)) return ItemKind::Prosign;
+    return ItemKind::Word;
+}
+
+} // namespace
+
+ItemCatalog::ItemCatalog() {
+    for (int c = 0; c < 128; ++c) {
+        if (lookup(static_cast<char>(c)) && !std::islower(c)) intern(std::string(1, static_cast<char>(c)));
+    }
+    for (auto &p : prosigns()) {
+        intern(p.first);
+    }
+}
+
+ItemId ItemCatalog::intern(const std::string& text) {
+    return intern(text, kindOf(fold(text)));
+}
+
+ItemId ItemCatalog::intern(const std::string& text, ItemKind kind) {
+    std::string key = fold(text);
+    auto it = ids_.find(key);
+    if (it != ids_.end()) return it->second;
+
+    ItemId id = static_cast<ItemId>(kind_.size());
+    std::string sending = MorseCore::sendingText(key);
+    std::string code;
+    ItemShape shape;
+    for (char c : sending) {
+        const char* pattern = lookup(c);
+        if (pattern) {
+            if (!code.empty()) code += ' ';
+            code += pattern;
+            for (const char* p = pattern; *p; ++p) {
+                ++(*p == '.' ? shape.dits : shape.dahs);
+            }
+            ++shape.chars;
+            shape.trailingSpaces = 0;
+        } else if (c == ' ') {
+            ++shape.spaces;
+            ++shape.trailingSpaces;
+        }
+    }
+    std::string lower = key;
+    for (char &c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    text_.push_back(text);
+    folded_.push_back(lower);
+    sending_.push_back(sending);
+    code_.push_back(code);
+    kind_.push_back(kind);
+    shape_.push_back(shape);
+    ids_.emplace(std::move(key), id);
+    return id;
+}
+
+std::vector<ItemId> ItemCatalog::intern(const std::vector<std::string>& texts) {
+    std::vector<ItemId> ids;
+    ids.reserve(texts.size());
+    for (const std::string& text : texts) {
+        ids.push_back(intern(text));
+    }
+    return ids;
+}
+
+ItemId ItemCatalog::find(const std::string& text) const {
+    auto it = ids_.find(fold(text));
+    return it != ids_.end() ? it->second : NO_ITEM;
+}
+
+ItemId ItemCatalog::character(char c) const {
+    return find(std::string(1, c));
+}
+
+bool ItemCatalog::matches(ItemId id, const std::string& answer) const {
+    const std::string& folded = folded_[id];
+    return answer.size() == folded.size() &&
+           std::equal(answer.begin(), answer.end(), folded.begin(), [](char a, char b) {
+               return std::tolower(static_cast<unsigned char>(a)) == b;
+           });
+}
+
+size_t ItemCatalog::audioLength(ItemId id, const Timing& timing) const {
+    const ItemShape& s = shape_[id];
+    return static_cast<size_t>(s.dits) * timing.ditSamples +
+           static_cast<size_t>(s.dahs) * timing.dahSamples +
+           static_cast<size_t>(s.dits + s.dahs) * timing.intraCharSamples +
+           static_cast<size_t>(s.chars) * timing.interCharSamples +
+           static_cast<size_t>(s.spaces) * timing.interWordSamples;
+}
+
+size_t ItemCatalog::lastToneEnd(ItemId id, const Timing& timing) const {
+    const ItemShape& s = shape_[id];
+    if (s.chars == 0) return 0;
+    // Everything but the gaps after the final element.
+    return audioLength(id, timing) - timing.intraCharSamples - timing.interCharSamples -
+           static_cast<size_t>(s.trailingSpaces) * timing.interWordSamples;
+}
+
+ItemCatalog& catalog() {
+    static ItemCatalog items;
+    return items;
+}
+
+std::vector<ItemId> buildPool(Category category, uint64_t seed) {
+    CW_TRACE_SPAN("select", "buildPool");
+    ItemCatalog& items = catalog();
+    std::vector<ItemId> pool;
+    if (category == Category::Callsigns) {
+        for (const std::string& call : generateCallsigns(CALLSIGN_POOL_SIZE, seed)) {
+            pool.push_back(items.intern(call, ItemKind::Callsign));
+        }
+        return pool;
+    }
+    if (category == Category::Letters || category == Category::Mixed) {
+        for (char c = 'A'; c <= 'Z'; ++c) pool.push_back(items.character(c));
+    }
+    if (category == Category::Numbers || category == Category::Mixed) {
+        for (char c = '0'; c <= '9'; ++c) pool.push_back(items.character(c));
+    }
+    if (category == Category::Prosigns) {
+        for (auto &p : prosigns()) pool.push_back(items.find(p.first));
+    }
+    if (category == Category::Punctuation) {
+        for (char c : punctuationChars) pool.push_back(items.character(c));
+    }
+    return pool;
+}
+
+ItemId sampleQuestion(const std::vector<ItemId>& pool, std::vector<bool>& used, std::mt19937& rng) {
+    if (pool.empty()) return NO_ITEM;
+    used.resize(pool.size());
+    bool fresh = std::find(used.begin(), used.end(), false) != used.end();
+    std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+    size_t i;
+    do {
+        i = pick(rng);
+    } while (fresh && used[i]);
+    used[i] = true;
+    return pool[i];
+}
+
+ItemId pickWeighted(const ItemTally& misses, const std::vector<ItemId>& pool, std::mt19937& rng) {
+    if (pool.empty()) return NO_ITEM;
+    uint64_t totalWeight = 0;
+    for (ItemId id : pool) {
+        totalWeight += 1 + misses.missesOf(id);
+    }
+    uint64_t r = std::uniform_int_distribution<uint64_t>(0, totalWeight - 1)(rng);
+    uint64_t cumulative = 0;
+    for (ItemId id : pool) {
+        cumulative += 1 + misses.missesOf(id);
+        if (r < cumulative) {
+            return id;
+        }
+    }
+    return pool.back();
+}
+
+ItemTally loadMissStats(const std::string& filename) {
+    CW_TRACE_SPAN("persist", "loadMissStats");
+    ItemTally stats;
+    std::ifstream fin(filename);
+    if (fin) {
+        std::string item;
+        int missCount;
+        while (fin >> item >> missCount) {
+            ItemId id = catalog().intern(item);
+            stats.grow(id);
+            stats.missed[id] = static_cast<uint32_t>(std::max(0, missCount));
+        }
+    }
+    return stats;
+}
+
+void saveMissStats(const ItemTally& stats, const std::string& filename) {
+    CW_TRACE_SPAN("persist", "saveMissStats");
+    ItemCatalog& items = catalog();
+    // Sorted by item, as the file has always been.
+    std::vector<ItemId> ids;
+    for (ItemId id = 0; id < stats.size(); ++id) {
+        if (stats.missed[id] > 0 && items.kind(id) != ItemKind::Callsign) ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end(),
+              [&](ItemId a, ItemId b) { return items.text(a) < items.text(b); });
+    std::ofstream fout(filename);
+    if (fout) {
+        for (ItemId id : ids) {
+            fout << items.text(id) << " " << stats.missed[id] << "\n";
+        }
+    }
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "morse_core.h"
+
+// ------------------------------------------------------------
+// Every item a mode can ask (characters, prosigns, words and
+// callsigns) under a dense integer id, with what each answer needs
+// worked out once when the item is added: its sending text, its
+// dot/dash code, its element counts (for the audio length at any
+// speed) and a folded form to compare answers against.
+//
+// Pools are vectors of ids and per-item counts are arrays indexed by
+// id (ItemTally), so grading an answer is a compare and a few
+// increments rather than string-keyed map lookups.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+using ItemId = uint32_t;
+static const ItemId NO_ITEM = UINT32_MAX;
+
+enum class ItemKind : uint8_t {
+    Character,
+    Prosign,
+    Word,
+    Callsign   // generated by buildPool(Category::Callsigns)
+};
+
+// Element counts of an item's sending text. With a Timing they give
+// the same lengths as messageLength() and lastToneEnd().
+struct ItemShape {
+    uint32_t dits = 0;
+    uint32_t dahs = 0;
+    uint32_t chars = 0;            // characters with a Morse mapping
+    uint32_t spaces = 0;
+    uint32_t trailingSpaces = 0;   // after the last of those characters
+};
+
+class ItemCatalog {
+public:
+    // Starts with every character in the Morse table and every prosign.
+    ItemCatalog();
+    ItemCatalog(const ItemCatalog&) = delete;
+    ItemCatalog& operator=(const ItemCatalog&) = delete;
+
+    // Id of text, adding it on first sight. Case does not matter; the
+    // first spelling seen is the one shown. The kind is fixed when the
+    // item is added: a single character, a prosign, or else a Word
+    // unless the caller says what it is.
+    ItemId intern(const std::string& text);
+    ItemId intern(const std::string& text, ItemKind kind);
+    std::vector<ItemId> intern(const std::vector<std::string>& texts);
+    // NO_ITEM if text was never added.
+    ItemId find(const std::string& text) const;
+    ItemId character(char c) const;
+
+    size_t size() const { return kind_.size(); }
+
+    // References stay valid as the catalog grows.
+    const std::string& text(ItemId id) const { return text_[id]; }
+    const std::string& sendingText(ItemId id) const { return sending_[id]; }
+    const std::string& code(ItemId id) const { return code_[id]; }   // ".- .-." for AR
+    ItemKind kind(ItemId id) const { return kind_[id]; }
+
+    // Case-insensitive, as the modes have always graded.
+    bool matches(ItemId id, const std::string& answer) const;
+
+    size_t audioLength(ItemId id, const Timing& timing) const;
+    size_t lastToneEnd(ItemId id, const Timing& timing) const;
+
+private:
+    std::deque<std::string> text_;
+    std::deque<std::string> folded_;
+    std::deque<std::string> sending_;
+    std::deque<std::string> code_;
+    std::vector<ItemKind> kind_;
+    std::vector<ItemShape> shape_;
+    std::unordered_map<std::string, ItemId> ids_;   // by folded text
+};
+
+// The catalog the modes share. Items are added from the main thread
+// only; nothing here locks.
+ItemCatalog& catalog();
+
+// Per-item counts, one array per count, indexed by ItemId. The arrays
+// grow to the largest id counted; ids beyond them count as zero.
+struct ItemTally {
+    std::vector<uint32_t> asked;
+    std::vector<uint32_t> correct;
+    std::vector<uint32_t> missed;
+
+    size_t size() const { return asked.size(); }
+    void grow(ItemId id) {
+        if (id >= asked.size()) {
+            asked.resize(id + 1);
+            correct.resize(id + 1);
+            missed.resize(id + 1);
+        }
+    }
+    void count(ItemId id, bool right) {
+        grow(id);
+        ++asked[id];
+        ++(right ? correct : missed)[id];
+    }
+    uint32_t missesOf(ItemId id) const { return id < missed.size() ? missed[id] : 0; }
+};
+
+// Items for a category. seed only matters for Callsigns, where the
+// same seed always gives the same pool.
+std::vector<ItemId> buildPool(Category category, uint64_t seed = 0);
+
+// Picks a question, avoiding repeats until every item has been used.
+// used holds one flag per pool entry.
+ItemId sampleQuestion(const std::vector<ItemId>& pool, std::vector<bool>& used, std::mt19937& rng);
+
+// Spaced-repetition pick: each pool item is weighted by 1 + misses.
+ItemId pickWeighted(const ItemTally& misses, const std::vector<ItemId>& pool, std::mt19937& rng);
+
+// All-time miss counts (the tally's missed column), one "ITEM COUNT"
+// pair per line. Generated callsigns are never saved; their misses
+// are counted against their characters.
+ItemTally loadMissStats(const std::string& filename);
+void saveMissStats(const ItemTally& stats, const std::string& filename);
+
+} // end namespace MorseCore
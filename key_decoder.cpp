@@ -0,0 +1,137 @@
+#include "key_decoder.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "morse_core.h"
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+// Marks or spaces shorter than this are contact bounce.
+const double DEBOUNCE_MS = 4.0;
+// Dot/dash and gap thresholds, in dits: halfway between the nominal
+// 1 and 3 (element vs character gap) and 3 and 7 (character vs word).
+const double DASH_DITS = 2.0;
+const double WORD_DITS = 5.0;
+
+} // namespace
+
+KeyDecoder::KeyDecoder(int initialWpm)
+    : ditMs_(1200.0 / (initialWpm > 0 ? initialWpm : 20)) {}
+
+double KeyDecoder::msSince(Clock::time_point from, Clock::time_point to) const {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+int KeyDecoder::wpm() const {
+    return static_cast<int>(1200.0 / ditMs_ + 0.5);
+}
+
+std::string KeyDecoder::addEdge(const KeyEdge& edge) {
+    if (edge.down == down_) {
+        return std::string();
+    }
+    std::string out;
+    if (edge.down) {
+        if (lastMarkValid_ && msSince(spaceStart_, edge.when) < DEBOUNCE_MS) {
+            // The key bounced open: the previous mark carries on.
+            pattern_.pop_back();
+            lastMarkValid_ = false;
+            down_ = true;
+            return out;
+        }
+        if (started_) {
+            out = flush(edge.when);
+        }
+        started_ = true;
+        down_ = true;
+        markStart_ = edge.when;
+        return out;
+    }
+
+    down_ = false;
+    double markMs = msSince(markStart_, edge.when);
+    if (markMs < DEBOUNCE_MS) {
+        lastMarkValid_ = false;   // a glitch, not an element
+        return out;
+    }
+    if (markMs < DASH_DITS * ditMs_) {
+        pattern_.push_back('.');
+        ditMs_ = 0.8 * ditMs_ + 0.2 * markMs;
+    } else {
+        pattern_.push_back('-');
+        ditMs_ = 0.8 * ditMs_ + 0.2 * markMs / 3.0;
+    }
+    ditMs_ = std::min(std::max(ditMs_, 1200.0 / 60), 1200.0 / 5);
+    lastMarkValid_ = true;
+    spaceStart_ = edge.when;
+    return out;
+}
+
+std::string KeyDecoder::flush(Clock::time_point now) {
+    std::string out;
+    if (down_ || !started_) {
+        return out;
+    }
+    double gapMs = msSince(spaceStart_, now);
+    if (!pattern_.empty() && gapMs >= DASH_DITS * ditMs_) {
+        char c = decode(pattern_);
+        out.push_back(c ? c : '*');
+        pattern_.clear();
+        lastMarkValid_ = false;
+        wordSpaceSent_ = false;
+    }
+    if (pattern_.empty() && !wordSpaceSent_ && gapMs >= WORD_DITS * ditMs_) {
+        out.push_back(' ');
+        wordSpaceSent_ = true;
+    }
+    return out;
+}
+
+KeyDecoder::Clock::time_point KeyDecoder::nextDeadline() const {
+    if (down_ || !started_) {
+        return Clock::time_point::max();
+    }
+    double dits;
+    if (!pattern_.empty()) {
+        dits = DASH_DITS;
+    } else if (!wordSpaceSent_) {
+        dits = WORD_DITS;
+    } else {
+        return Clock::time_point::max();
+    }
+    return spaceStart_ + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(dits * ditMs_));
+}
+
+std::vector<KeyEdge> loadKeyEdges(const std::string& filename,
+                                  std::chrono::steady_clock::time_point base) {
+    CW_TRACE_SPAN("persist", "loadKeyEdges");
+    std::vector<KeyEdge> edges;
+    std::ifstream fin(filename);
+    long long us;
+    int down;
+    while (fin >> us >> down) {
+        edges.push_back({down != 0, base + std::chrono::microseconds(us)});
+    }
+    return edges;
+}
+
+bool saveKeyEdges(const std::vector<KeyEdge>& edges, const std::string& filename) {
+    CW_TRACE_SPAN("persist", "saveKeyEdges");
+    std::ofstream fout(filename);
+    if (!fout) {
+        return false;
+    }
+    for (const KeyEdge& e : edges) {
+        long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+            e.when - edges.front().when).count();
+        fout << us << " " << (e.down ? 1 : 0) << "\n";
+    }
+    return true;
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Straight-key / bug decoding. Input is a stream of key edges
+// with monotonic timestamps; output is text. The dit length is
+// learnt from the student's own marks, so the decoder follows
+// them as they speed up or slow down.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+struct KeyEdge {
+    bool down;
+    std::chrono::steady_clock::time_point when;
+};
+
+class KeyDecoder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit KeyDecoder(int initialWpm = 20);
+
+    // Feeds one transition; returns any characters it completed.
+    std::string addEdge(const KeyEdge& edge);
+    // Completes a pending character (or word space) once the key has
+    // been up long enough; call at nextDeadline().
+    std::string flush(Clock::time_point now);
+    // When flush() would next produce output; time_point::max() if never.
+    Clock::time_point nextDeadline() const;
+
+    double ditMs() const { return ditMs_; }
+    int wpm() const;
+
+private:
+    double msSince(Clock::time_point from, Clock::time_point to) const;
+
+    double ditMs_;
+    bool down_ = false;
+    bool started_ = false;
+    bool lastMarkValid_ = false;
+    bool wordSpaceSent_ = true;
+    std::string pattern_;
+    Clock::time_point markStart_;
+    Clock::time_point spaceStart_;
+};
+
+// Recorded edges, one "MICROSECONDS 0|1" line each, timed from the
+// first edge. Loaded edges are placed relative to `base`.
+std::vector<KeyEdge> loadKeyEdges(const std::string& filename,
+                                  std::chrono::steady_clock::time_point base);
+bool saveKeyEdges(const std::vector<KeyEdge>& edges, const std::string& filename);
+
+} // end namespace MorseCore
@@ -0,0 +1,183 @@
+#include "key_input.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+namespace {
+
+// Interrupts the blocked TIOCMIWAIT on stop(); installed without
+// SA_RESTART so the ioctl returns EINTR.
+void wakeSignal(int) {}
+
+void installWakeSignal() {
+    static bool installed = false;
+    if (installed) return;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = wakeSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR2, &sa, nullptr);
+    installed = true;
+}
+
+} // namespace
+
+SerialKeyInput::~SerialKeyInput() {
+    stop();
+    if (fd_ >= 0) close(fd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+}
+
+bool SerialKeyInput::open(const std::string& device, int lines) {
+    fd_ = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        error_ = "Error opening " + device + ": " + strerror(errno);
+        return false;
+    }
+    // Raise RTS and DTR so a key across RTS-CTS or DTR-DSR has a source.
+    int out = TIOCM_RTS | TIOCM_DTR;
+    ioctl(fd_, TIOCMBIS, &out);
+    int status;
+    if (ioctl(fd_, TIOCMGET, &status) != 0) {
+        error_ = device + " has no modem-control lines: " + strerror(errno);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    lines_ = lines;
+    return true;
+}
+
+bool SerialKeyInput::start(EventLoop& loop, KeyEdgeHandler handler, std::function<void()> onFailure) {
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd_ < 0) {
+        error_ = std::string("eventfd: ") + strerror(errno);
+        return false;
+    }
+    if (!loop.watch(wakeFd_, [this](uint32_t) { deliver(); })) {
+        error_ = std::string("Cannot watch the key's eventfd: ") + strerror(errno);
+        close(wakeFd_);
+        wakeFd_ = -1;
+        return false;
+    }
+    loop_ = &loop;
+    handler_ = std::move(handler);
+    onFailure_ = std::move(onFailure);
+    installWakeSignal();
+    running_ = true;
+    exited_ = false;
+    failed_ = false;
+    thread_ = std::thread([this] { waitLoop(); });
+    return true;
+}
+
+void SerialKeyInput::stop() {
+    if (!running_) return;
+    running_ = false;
+    // The thread may be between ioctls when the first signal lands.
+    while (!exited_) {
+        pthread_kill(thread_.native_handle(), SIGUSR2);
+        usleep(1000);
+    }
+    thread_.join();
+    loop_->unwatch(wakeFd_);
+    loop_ = nullptr;
+}
+
+void SerialKeyInput::waitLoop() {
+    int status = 0;
+    ioctl(fd_, TIOCMGET, &status);
+    bool down = (status & lines_) != 0;
+    // Anything but a wake-up from stop() ends the session; the loop
+    // hears about it through the eventfd like an edge.
+    auto fail = [this](const char* what) {
+        error_ = std::string(what) + ": " + strerror(errno);
+        failed_ = true;
+        uint64_t one = 1;
+        (void)write(wakeFd_, &one, sizeof(one));
+    };
+    while (running_) {
+        if (ioctl(fd_, TIOCMIWAIT, lines_) != 0) {
+            if (errno == EINTR) continue;
+            fail("The key port cannot wait for line changes");
+            break;
+        }
+        // Stamp first: everything after this adds to the measured latency.
+        MorseCore::KeyEdge edge = {false, std::chrono::steady_clock::now()};
+        if (ioctl(fd_, TIOCMGET, &status) != 0) {
+            fail("The key port stopped reporting its lines");
+            break;
+        }
+        edge.down = (status & lines_) != 0;
+        if (edge.down == down) {
+            continue;   // changed and changed back before we looked
+        }
+        down = edge.down;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(edge);
+        }
+        uint64_t one = 1;
+        (void)write(wakeFd_, &one, sizeof(one));
+    }
+    exited_ = true;
+}
+
+void SerialKeyInput::deliver() {
+    uint64_t count;
+    (void)read(wakeFd_, &count, sizeof(count));
+    std::vector<MorseCore::KeyEdge> edges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        edges.swap(pending_);
+    }
+    for (const MorseCore::KeyEdge& e : edges) {
+        handler_(e);
+    }
+    if (failed_ && onFailure_) {
+        onFailure_();
+    }
+}
+
+bool ReplayKeyInput::start(EventLoop& loop, std::vector<MorseCore::KeyEdge> edges,
+                           KeyEdgeHandler handler, EventLoop::Clock::duration lead) {
+    if (edges.empty()) return false;
+    stop();
+    loop_ = &loop;
+    handler_ = std::move(handler);
+    EventLoop::Clock::duration shift = EventLoop::Clock::now() + lead - edges.front().when;
+    for (MorseCore::KeyEdge& e : edges) {
+        e.when += shift;
+    }
+    edges_ = std::move(edges);
+    next_ = 0;
+    timer_ = loop.addTimer(edges_[0].when, [this] { fire(); });
+    return timer_ >= 0;
+}
+
+void ReplayKeyInput::stop() {
+    if (loop_ && timer_ >= 0) {
+        loop_->cancelTimer(timer_);
+    }
+    timer_ = -1;
+    loop_ = nullptr;
+}
+
+void ReplayKeyInput::fire() {
+    timer_ = -1;
+    // The edge is stamped when it is delivered, like a live one would be.
+    MorseCore::KeyEdge edge = edges_[next_++];
+    edge.when = EventLoop::Clock::now();
+    if (next_ < edges_.size()) {
+        timer_ = loop_->addTimer(edges_[next_].when, [this] { fire(); });
+    }
+    handler_(edge);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_loop.h"
+#include "key_decoder.h"
+
+// ------------------------------------------------------------
+// Key edge sources for straight-key and bug practice. Both hand
+// their edges to a callback on the event loop's thread.
+// ------------------------------------------------------------
+using KeyEdgeHandler = std::function<void(const MorseCore::KeyEdge&)>;
+
+// A key wired across a serial port's modem-control lines (e.g. RTS to
+// CTS or DTR to DSR). TIOCMIWAIT blocks, so one thread waits on the
+// lines and stamps each change with the monotonic clock the moment it
+// wakes; an eventfd carries the edges over to the loop.
+class SerialKeyInput {
+public:
+    SerialKeyInput() = default;
+    ~SerialKeyInput();
+    SerialKeyInput(const SerialKeyInput&) = delete;
+    SerialKeyInput& operator=(const SerialKeyInput&) = delete;
+
+    // lines: TIOCM_CTS, TIOCM_DSR or both; the key is down while any is set.
+    bool open(const std::string& device, int lines);
+    // onFailure runs on the loop if the wait thread gives up (a driver
+    // without TIOCMIWAIT, a device unplugged); error() says why.
+    bool start(EventLoop& loop, KeyEdgeHandler handler, std::function<void()> onFailure = nullptr);
+    void stop();
+    bool failed() const { return failed_; }
+    const std::string& error() const { return error_; }
+
+private:
+    void waitLoop();
+    void deliver();
+
+    int fd_ = -1;
+    int wakeFd_ = -1;
+    int lines_ = 0;
+    std::string error_;
+    EventLoop* loop_ = nullptr;
+    KeyEdgeHandler handler_;
+    std::function<void()> onFailure_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> exited_{true};
+    std::atomic<bool> failed_{false};   // set after error_, by the wait thread
+    std::mutex mutex_;
+    std::vector<MorseCore::KeyEdge> pending_;
+};
+
+// Plays back recorded edges on the loop at their original spacing.
+class ReplayKeyInput {
+public:
+    ~ReplayKeyInput() { stop(); }
+
+    // Edges are shifted so the first one falls `lead` from now.
+    bool start(EventLoop& loop, std::vector<MorseCore::KeyEdge> edges,
+               KeyEdgeHandler handler,
+               EventLoop::Clock::duration lead = std::chrono::milliseconds(200));
+    void stop();
+    bool finished() const { return next_ >= edges_.size(); }
+
+private:
+    void fire();
+
+    EventLoop* loop_ = nullptr;
+    KeyEdgeHandler handler_;
+    std::vector<MorseCore::KeyEdge> edges_;
+    size_t next_ = 0;
+    EventLoop::TimerId timer_ = -1;
+};
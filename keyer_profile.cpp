@@ -0,0 +1,98 @@
+#include "keyer_profile.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "trace.h"
+
+namespace WinKeyerCore {
+
+namespace {
+
+unsigned char byteOf(int v) {
+    return static_cast<unsigned char>(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+} // namespace
+
+std::vector<unsigned char> speedCommand(const KeyerSettings& s) {
+    return {static_cast<unsigned char>(s.bufferedSpeed ? 0x1C : 0x02), byteOf(s.wpm)};
+}
+
+std::vector<unsigned char> settingsCommands(const KeyerSettings& s) {
+    std::vector<unsigned char> cmds = {0x0E, s.mode};
+    std::vector<unsigned char> speed = speedCommand(s);
+    cmds.insert(cmds.end(), speed.begin(), speed.end());
+    unsigned char rest[] = {
+        0x03, byteOf(s.weighting),
+        0x17, byteOf(s.ditDahRatio),
+        0x11, byteOf(s.keyCompMs),
+        0x04, byteOf(s.pttLeadMs / 10), byteOf(s.pttTailMs / 10),
+        0x05, byteOf(s.potMinWpm), byteOf(s.potMaxWpm - s.potMinWpm), 0,
+        0x09, s.pinCfg,
+        0x0D, byteOf(s.farnsworthWpm),   // 0 turns Farnsworth off
+    };
+    cmds.insert(cmds.end(), rest, rest + sizeof(rest));
+    return cmds;
+}
+
+std::map<std::string, KeyerSettings> loadKeyerProfiles(const std::string& filename) {
+    CW_TRACE_SPAN("persist", "loadKeyerProfiles");
+    std::map<std::string, KeyerSettings> profiles;
+    std::ifstream fin(filename);
+    std::string line;
+    KeyerSettings* current = nullptr;
+    while (std::getline(fin, line)) {
+        if (line.size() > 2 && line.front() == '[' && line.back() == ']') {
+            current = &profiles[line.substr(1, line.size() - 2)];
+            continue;
+        }
+        std::istringstream in(line);
+        std::string key;
+        int value;
+        if (!current || !(in >> key >> value)) {
+            continue;
+        }
+        if (key == "wpm") current->wpm = value;
+        else if (key == "weighting") current->weighting = value;
+        else if (key == "farnsworth") current->farnsworthWpm = value;
+        else if (key == "ratio") current->ditDahRatio = value;
+        else if (key == "keycomp") current->keyCompMs = value;
+        else if (key == "ptt_lead") current->pttLeadMs = value;
+        else if (key == "ptt_tail") current->pttTailMs = value;
+        else if (key == "pincfg") current->pinCfg = byteOf(value);
+        else if (key == "pot_min") current->potMinWpm = value;
+        else if (key == "pot_max") current->potMaxWpm = value;
+        else if (key == "mode") current->mode = byteOf(value);
+        else if (key == "buffered_speed") current->bufferedSpeed = value != 0;
+    }
+    return profiles;
+}
+
+bool saveKeyerProfiles(const std::map<std::string, KeyerSettings>& profiles,
+                       const std::string& filename) {
+    CW_TRACE_SPAN("persist", "saveKeyerProfiles");
+    std::ofstream fout(filename);
+    if (!fout) {
+        return false;
+    }
+    for (auto& entry : profiles) {
+        const KeyerSettings& s = entry.second;
+        fout << "[" << entry.first << "]\n"
+             << "wpm " << s.wpm << "\n"
+             << "weighting " << s.weighting << "\n"
+             << "farnsworth " << s.farnsworthWpm << "\n"
+             << "ratio " << s.ditDahRatio << "\n"
+             << "keycomp " << s.keyCompMs << "\n"
+             << "ptt_lead " << s.pttLeadMs << "\n"
+             << "ptt_tail " << s.pttTailMs << "\n"
+             << "pincfg " << static_cast<int>(s.pinCfg) << "\n"
+             << "pot_min " << s.potMinWpm << "\n"
+             << "pot_max " << s.potMaxWpm << "\n"
+             << "mode " << static_cast<int>(s.mode) << "\n"
+             << "buffered_speed " << (s.bufferedSpeed ? 1 : 0) << "\n";
+    }
+    return static_cast<bool>(fout);
+}
+
+} // end namespace WinKeyerCore
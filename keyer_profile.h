@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// WinKeyer settings as one value, the host commands that put a
+// keyer into that state, and named profiles saved between runs.
+// ------------------------------------------------------------
+namespace WinKeyerCore {
+
+struct KeyerSettings {
+    int wpm = 20;
+    int weighting = 50;          // percent, 10-90
+    int farnsworthWpm = 0;       // 0 = off, else 10-99
+    int ditDahRatio = 50;        // 33-66, 50 = 1:3
+    int keyCompMs = 0;           // 0-250
+    int pttLeadMs = 0;           // 0-250, sent in 10 ms steps
+    int pttTailMs = 0;
+    unsigned char pinCfg = 0x0F; // 0x0F = internal speaker on
+    int potMinWpm = 5;
+    int potMaxWpm = 35;
+    unsigned char mode = 0xC4;   // iambic B, paddle and serial echo
+    bool bufferedSpeed = false;  // speed changes via 0x1C rather than 0x02
+};
+
+// The keyer's own sidetone is on while pin config bit 1 is set.
+inline bool internalSpeakerOn(const KeyerSettings& s) {
+    return (s.pinCfg & 0x02) != 0;
+}
+
+// Command bytes for the speed change alone, honouring bufferedSpeed.
+std::vector<unsigned char> speedCommand(const KeyerSettings& s);
+
+// Every setting as one host-mode command sequence, to be written in a
+// single batch after host open.
+std::vector<unsigned char> settingsCommands(const KeyerSettings& s);
+
+// Profiles are kept as "[name]" sections of "key value" lines; unknown
+// keys are skipped so older builds can read newer files.
+std::map<std::string, KeyerSettings> loadKeyerProfiles(const std::string& filename);
+bool saveKeyerProfiles(const std::map<std::string, KeyerSettings>& profiles,
+                       const std::string& filename);
+
+} // end namespace WinKeyerCore
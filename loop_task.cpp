@@ -0,0 +1,30 @@
+#include "loop_task.h"
+
+bool SleepAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+    // Without a timer there is nothing to wait on; carry straight on.
+    return loop_.addTimer(deadline_, [waiting] { waiting.resume(); }) >= 0;
+}
+
+bool ReadableAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+    waiting_ = waiting;
+    if (!loop_.watch(fd_, [this](uint32_t) { finish(true); })) {
+        ready_ = true;
+        return false;
+    }
+    if (deadline_ != EventLoop::Clock::time_point::max()) {
+        timer_ = loop_.addTimer(deadline_, [this] {
+            timer_ = -1;   // released by the loop as it fires
+            finish(false);
+        });
+    }
+    return true;
+}
+
+void ReadableAwaiter::finish(bool ready) {
+    ready_ = ready;
+    loop_.unwatch(fd_);
+    if (timer_ >= 0) loop_.cancelTimer(timer_);
+    timer_ = -1;
+    // Last, since resuming may destroy this awaiter.
+    waiting_.resume();
+}
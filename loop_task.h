@@ -0,0 +1,169 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "event_loop.h"
+
+// ------------------------------------------------------------
+// Coroutines on an EventLoop. A mode written as a Task reads like
+// the blocking loop it replaces, but each co_await hands control
+// back to the loop, so a key, a deadline and the end of a sound are
+// all watched at once and whichever comes first wins.
+//
+// A Task starts when it is awaited (or handed to runTask) and
+// resumes whoever awaited it when it finishes; an exception thrown
+// inside comes out of the co_await.
+//
+//     Task<bool> ask(EventLoop& loop) {
+//         co_return co_await readable(loop, STDIN_FILENO, deadline);
+//     }
+//     bool answered = runTask(loop, ask(loop));
+// ------------------------------------------------------------
+template <class T = void>
+class Task;
+
+namespace LoopTaskDetail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Hands over to the awaiting coroutine without growing the stack.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> done) noexcept {
+            return done.promise().continuation;
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+    void rethrow() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+template <class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+    void return_value(T v) { value = std::move(v); }
+    T take() {
+        rethrow();
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    void return_void() {}
+    void take() { rethrow(); }
+};
+
+} // namespace LoopTaskDetail
+
+template <class T>
+class Task {
+public:
+    struct promise_type : LoopTaskDetail::Promise<T> {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    // Awaiting a Task runs it until it finishes.
+    bool await_ready() const noexcept { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    template <class U>
+    friend U runTask(EventLoop& loop, Task<U> task);
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs task to completion, dispatching the loop's events meanwhile;
+// the one place a blocking caller meets the coroutines.
+template <class T>
+T runTask(EventLoop& loop, Task<T> task) {
+    task.handle_.resume();
+    while (!task.done()) {
+        loop.runOnce(-1);
+    }
+    return task.handle_.promise().take();
+}
+
+// co_await sleepUntil(loop, t): resumes at t.
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop& loop, EventLoop::Clock::time_point deadline)
+        : loop_(loop), deadline_(deadline) {}
+    bool await_ready() const { return EventLoop::Clock::now() >= deadline_; }
+    bool await_suspend(std::coroutine_handle<> waiting);
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop& loop_;
+    EventLoop::Clock::time_point deadline_;
+};
+
+// co_await readable(loop, fd, deadline): true once fd can be read,
+// false if the deadline comes first. The default deadline never
+// comes. A file epoll cannot watch (a plain file) counts as readable.
+class ReadableAwaiter {
+public:
+    ReadableAwaiter(EventLoop& loop, int fd, EventLoop::Clock::time_point deadline)
+        : loop_(loop), fd_(fd), deadline_(deadline) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiting);
+    bool await_resume() const noexcept { return ready_; }
+
+private:
+    void finish(bool ready);
+
+    EventLoop& loop_;
+    int fd_;
+    EventLoop::Clock::time_point deadline_;
+    EventLoop::TimerId timer_ = -1;
+    std::coroutine_handle<> waiting_;
+    bool ready_ = false;
+};
+
+inline SleepAwaiter sleepUntil(EventLoop& loop, EventLoop::Clock::time_point deadline) {
+    return SleepAwaiter(loop, deadline);
+}
+
+inline SleepAwaiter sleepFor(EventLoop& loop, EventLoop::Clock::duration delay) {
+    return SleepAwaiter(loop, EventLoop::Clock::now() + delay);
+}
+
+inline ReadableAwaiter readable(EventLoop& loop, int fd,
+                                EventLoop::Clock::time_point deadline = EventLoop::Clock::time_point::max()) {
+    return ReadableAwaiter(loop, fd, deadline);
+}
@@ -1,4 +1,3 @@
-#include <SFML/Audio.hpp>
 #include <iostream>
 #include <map>
 #include <vector>
@@ -20,210 +19,374 @@
 #include <termios.h>
 #include <unistd.h>
 #include <csignal>
+#include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sstream>
+#include <iomanip>
+#include <functional>
+#include <memory>
+#include <deque>
+
+#include "audio_engine.h"
+#include "copy_grading.h"
+#include "event_loop.h"
+#include "item_catalog.h"
+#include "key_decoder.h"
+#include "key_input.h"
+#include "keyer_profile.h"
+#include "loop_task.h"
+#include "metrics.h"
+#include "metrics_exporter.h"
+#include "morse_core.h"
+#include "qso_text.h"
+#include "sending_analysis.h"
+#include "speed_controller.h"
+#include "term_renderer.h"
+#include "text_follower.h"
+#include "trace.h"
+#include "trainer_session.h"
+#include "winkeyer_core.h"
+#include "winkeyer_serial.h"
 
 // A global clearScreen used in the top‐level menu:
 void globalClearScreen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    system("clear");
-#endif
+    terminal().clearScreen();
 }
 
 namespace MorseModule {
 
-// --- getch() helper ---
-#ifdef _WIN32
-  #include <conio.h>
-#else
-char getch() {
-    struct termios oldt, newt;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    char ch = getchar();
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return ch;
+std::mt19937 rng(static_cast<unsigned int>(time(nullptr)));
+
+// clearScreen (for Morse module)
+void clearScreen() {
+    terminal().clearScreen();
 }
-#endif
 
-// Global Morse code maps and other globals
-std::map<char, std::string> morseCode = {
-    {'A', ".-"},   {'B', "-..."},
-    {'C', "-.-."}, {'D', "-.."},
-    {'E', "."},    {'F', "..-."},
-    {'G', "--."},  {'H', "...."},
-    {'I', ".."},   {'J', ".---"},
-    {'K', "-.-"},  {'L', ".-.."},
-    {'M', "--"},   {'N', "-."},
-    {'O', "---"},  {'P', ".--."},
-    {'Q', "--.-"}, {'R', ".-."},
-    {'S', "..."},  {'T', "-"},
-    {'U', "..-"},  {'V', "...-"},
-    {'W', ".--"},  {'X', "-..-"},
-    {'Y', "-.--"}, {'Z', "--.."},
-    {'0', "-----"},{'1', ".----"},
-    {'2', "..---"},{'3', "...--"},
-    {'4', "....-"},{'5', "....."},
-    {'6', "-...."},{'7', "--..."},
-    {'8', "---.."},{'9', "----."}
-};
+// Output picked on the command line (--audio, --period).
+AudioOptions audioOptions;
+
+// Shared output stream, started on first use. If the chosen output
+// will not open, the modes carry on with the null one and keep time.
+AudioEngine& audio() {
+    static std::unique_ptr<AudioEngine> engine;
+    if (!engine) {
+        std::string error;
+        engine.reset(new AudioEngine(MorseCore::SAMPLE_RATE, makeAudioBackend(audioOptions, error)));
+        if (!engine->start()) {
+            std::cerr << "Audio: " << engine->error() << "; continuing without sound.\n";
+            AudioOptions silent = audioOptions;
+            silent.backend = "null";
+            engine.reset(new AudioEngine(MorseCore::SAMPLE_RATE, makeAudioBackend(silent, error)));
+            engine->start();
+        }
+    }
+    return *engine;
+}
 
-static void addPunctuation() {
-    morseCode['.'] = ".-.-.-";  
-    morseCode[','] = "--..--";  
-    morseCode['?'] = "..--..";  
-    morseCode['!'] = "-.-.--";  
-    morseCode['-'] = "-....-";  
-    morseCode['/'] = "-..-.";   
-    morseCode['('] = "-.--.";   
-    morseCode[')'] = "-.--.-";  
-    morseCode[':'] = "---...";  
-    morseCode[';'] = "-.-.-.";  
-    morseCode['='] = "-...-";   
-    morseCode['+'] = ".-.-.";   
-    morseCode['\"'] = ".-..-."; 
-    morseCode['\''] = ".----."; 
-    morseCode['&'] = ".-...";   
-    morseCode['_'] = "..--.-";  
-    morseCode['@'] = ".--.-.";  
-}
-
-std::map<std::string, std::string> prosigns = {
-    {"AR", "AR"},
-    {"AS", "AS"},
-    {"BK", "BK"},
-    {"BT", "BT"},
-    {"KA", "KA"},
-    {"KN", "KN"}, 
-    {"CL", "CL"},
-    {"CQ", "CQ"},
-    {"K",  "K"},
-    {"R",  "R"},
-    {"SK", "SK"},
-    {"VE", "VE"}
-};
+// Pitch last chosen for the receiving modes; sidetone uses it too.
+float tonePitch = 800.0f;
+
+// Edge-to-speaker budget for live sidetone. Beyond about 10 ms the tone
+// is heard trailing the key, which throws off a student's timing.
+const double SIDETONE_BUDGET_MS = 10.0;
+
+// "median / 90% / max" of a set of latencies, in ms.
+std::string latencySummary(std::vector<double> ms) {
+    if (ms.empty())
+        return "no edges yet";
+    std::sort(ms.begin(), ms.end());
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "median " << ms[(ms.size() - 1) / 2] << " ms, 90% under "
+        << ms[(ms.size() - 1) * 9 / 10] << " ms, max " << ms.back()
+        << " ms (" << ms.size() << " edges)";
+    if (ms[(ms.size() - 1) * 9 / 10] > SIDETONE_BUDGET_MS)
+        out << ", over the " << static_cast<int>(SIDETONE_BUDGET_MS) << " ms budget";
+    return out.str();
+}
 
-std::vector<char> letters;
-std::vector<char> numbers;
+// Live sidetone for the sending modes, in the receiving modes' tone:
+// same pitch, same full-scale keyed sine. While one exists the engine
+// runs short chunks; a timer on the loop keeps the playback clock fresh
+// and collects each edge's latency to the speaker, calling onMeasured
+// when new ones arrive.
+class Sidetone {
+public:
+    Sidetone(EventLoop& loop, float pitch, std::function<void()> onMeasured = nullptr)
+        : loop_(loop), onMeasured_(std::move(onMeasured)) {
+        AudioEngine& engine = audio();
+        engine.setSidetonePitch(pitch);
+        engine.setLowLatency(true);
+        engine.takeSidetoneLatencies();   // drop anything from an earlier session
+        tick();
+    }
+    ~Sidetone() {
+        if (timer_ >= 0)
+            loop_.cancelTimer(timer_);
+        keyEdge(false, EventLoop::Clock::now());
+        audio().setLowLatency(false);
+    }
+    Sidetone(const Sidetone&) = delete;
+    Sidetone& operator=(const Sidetone&) = delete;
 
-static const std::vector<char> punctuationChars = {
-    '.', ',', '?', '!', '-', '/', '(', ')',
-    ':', ';', '=', '+', '\"', '\'', '&', '_', '@'
-};
+    void keyEdge(bool down, EventLoop::Clock::time_point when) {
+        if (down == down_)
+            return;
+        down_ = down;
+        audio().keyEdge(down, when);
+    }
+    const std::vector<double>& latencies() const { return latencies_; }
+    std::string summary() const { return latencySummary(latencies_); }
+
+private:
+    void tick() {
+        AudioEngine& engine = audio();
+        engine.poll();
+        std::vector<double> fresh = engine.takeSidetoneLatencies();
+        latencies_.insert(latencies_.end(), fresh.begin(), fresh.end());
+        timer_ = loop_.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(50), [this] { tick(); });
+        if (!fresh.empty() && onMeasured_)
+            onMeasured_();
+    }
 
-static const std::vector<std::vector<char>> letterGroups = {
-    {'E','I','S','H'},
-    {'T','M','O'},
-    {'A','U','V','N','D','B'},
-    {'F','L','G','W','Q','Y'},
-    {'K','R','P','X'},
-    {'C','J','Z'}
+    EventLoop& loop_;
+    std::function<void()> onMeasured_;
+    EventLoop::TimerId timer_ = -1;
+    bool down_ = false;
+    std::vector<double> latencies_;
 };
 
-// clearScreen (for Morse module)
-void clearScreen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    system("clear");
-#endif
+// Play rendered samples and block until they have left the sound card.
+void playSamples(const std::vector<short>& samples) {
+    if (samples.empty()) return;
+    CW_TRACE_SPAN("playback", "playSamples");
+    uint64_t startFrame = audio().enqueue(samples.data(), samples.size());
+    audio().waitForFrame(startFrame + samples.size());
 }
 
-// Play a beep using SFML (requires linking to SFML libraries)
-void playBeep(float frequency, float durationSeconds) {
-    const int sampleRate = 44100;
-    const int numSamples = static_cast<int>(sampleRate * durationSeconds);
-    short* samples = new short[numSamples];
+void playMorseCode(const std::string& text, float pitch, int wpm, int effectiveWpm) {
+    std::vector<short> samples;
+    auto renderStart = std::chrono::steady_clock::now();
+    MorseCore::renderMessageParallel(text, pitch, MorseCore::makeTiming(wpm, effectiveWpm), samples);
+    MorseCore::metrics().renderSeconds.observe(std::chrono::steady_clock::now() - renderStart);
+    playSamples(samples);
+}
 
-    for (int i = 0; i < numSamples; ++i) {
-        samples[i] = static_cast<short>(
-            32767 * sin(2.0 * 3.14159 * frequency * i / sampleRate)
-        );
+// Plays the text nextText() hands out until it returns "", rendering a
+// period at a time about a second ahead of the speaker, so text is only
+// generated as fast as it is heard. Each piece ends with a pause.
+void streamMorse(const std::function<std::string()>& nextText, float pitch, int wpm, int effectiveWpm) {
+    CW_TRACE_SPAN("playback", "streamMorse");
+    const uint64_t ahead = MorseCore::SAMPLE_RATE;
+    MorseCore::Timing timing = MorseCore::makeTiming(wpm, effectiveWpm);
+    MorseCore::MessageRenderer renderer;
+    std::vector<short> period(1024);
+    uint64_t end = 0;
+    for (;;) {
+        size_t n = renderer.render(period.data(), period.size());
+        if (n == 0) {
+            std::string text = nextText();
+            if (text.empty()) break;
+            renderer = MorseCore::MessageRenderer(text + "   ", pitch, timing);
+            continue;
+        }
+        end = audio().enqueue(period.data(), n) + n;
+        if (end > ahead) audio().waitForFrame(end - ahead);
     }
+    if (end > 0) audio().waitForFrame(end);
+}
+
+// Queues the current question's audio without waiting for it; returns
+// the frame number at which it starts playing.
+uint64_t queueQuestion(MorseCore::Session& session) {
+    MorseCore::Metrics& metrics = MorseCore::metrics();
+    auto renderStart = std::chrono::steady_clock::now();
+    std::vector<short> samples(session.audioLength());
+    samples.resize(session.renderAudio(samples.data(), samples.size()));
+    auto rendered = std::chrono::steady_clock::now();
+    metrics.renderSeconds.observe(rendered - renderStart);
+    CW_TRACE_COMPLETE("synth", "render question", renderStart, rendered);
+    uint64_t startFrame = audio().enqueue(samples.data(), samples.size());
+    if (session.answeredAt() != std::chrono::steady_clock::time_point()) {
+        // Every question opens on a tone, so its first frame is the one
+        // the student is waiting to hear.
+        audio().poll();
+        metrics.answerToTone.observe(audio().timeOfFrame(startFrame) - session.answeredAt());
+    }
+    return startFrame;
+}
+
+void playQuestion(MorseCore::Session& session) {
+    CW_TRACE_SPAN("playback", "playQuestion");
+    uint64_t startFrame = queueQuestion(session);
+    audio().waitForFrame(startFrame + session.audioLength());
+}
 
-    sf::SoundBuffer buffer;
-    if (!buffer.loadFromSamples(samples, numSamples, 1, sampleRate)) {
-        std::cerr << "Failed to load audio buffer.\n";
+// Keeps stdin unbuffered and unechoed for its lifetime, so no terminal
+// mode switch lands inside a timed response.
+class RawInput {
+public:
+    RawInput() {
+        tcgetattr(STDIN_FILENO, &saved_);
+        struct termios raw = saved_;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    ~RawInput() {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
     }
+private:
+    struct termios saved_;
+};
+
+struct KeyPress {
+    char key;
+    std::chrono::steady_clock::time_point when;
+};
 
-    sf::Sound sound;
-    sound.setBuffer(buffer);
-    sound.play();
+// Blocks for one key; the timestamp is taken as soon as read() returns.
+KeyPress readKey() {
+    CW_TRACE_SPAN("input", "readKey");
+    char c = 0;
+    if (read(STDIN_FILENO, &c, 1) != 1) c = 0;
+    return {c, std::chrono::steady_clock::now()};
+}
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(
-        static_cast<int>(durationSeconds * 1000.0f)
-    ));
-    delete[] samples;
+// The loop the receiving modes run their questions on. Audio plays
+// on its own thread; the loop waits on the keyboard, on deadlines and
+// on the moment a question's sound is due to end.
+EventLoop& modeLoop() {
+    static EventLoop loop;
+    return loop;
 }
 
-void playMorseCode(const std::string& text, float pitch, int wpm, int effectiveWpm) {
-    float unitDuration       = 1200.0f / wpm;        
-    float farnsworthDuration = 1200.0f / effectiveWpm; 
-
-    float intraCharSpace = unitDuration;
-    float interCharSpace = farnsworthDuration * 3; 
-    float interWordSpace = farnsworthDuration * 7;  
-
-    for (char c : text) {
-        char upperC = static_cast<char>(toupper(c));
-        auto it = morseCode.find(upperC);
-        if (it != morseCode.end()) {
-            const std::string& pattern = it->second;
-            for (char symbol : pattern) {
-                if (symbol == '.') {
-                    playBeep(pitch, unitDuration / 1000.f);
-                } else if (symbol == '-') {
-                    playBeep(pitch, (3 * unitDuration) / 1000.f);
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(
-                    static_cast<int>(intraCharSpace)
-                ));
+// Stop a question's sound as soon as it is answered correctly
+// (chosen with the receiving speeds).
+bool cutShortOnAnswer = false;
+
+// How askQuestion takes an answer.
+struct AnswerRules {
+    bool wholeLine = false;      // typed and echoed up to ENTER; else one key
+    double timeLimitSec = 0.0;   // from the final element; 0 = no limit
+    bool cutShort = false;       // a correct answer ends the sound early
+    std::string prompt;          // shown as the sound starts
+};
+
+struct Answer {
+    std::string text;
+    std::chrono::steady_clock::time_point when;      // the key that finished it
+    std::chrono::steady_clock::time_point toneEnd;   // final element (due) off the speaker
+    bool early = false;      // finished before the final element had ended
+    bool cutShort = false;   // the rest of the question's sound was dropped
+    bool expired = false;    // the time limit passed first; text is what was typed
+
+    // From the final element to the answer; 0 when typed ahead of it.
+    double responseSec() const {
+        return std::max(0.0, std::chrono::duration<double>(when - toneEnd).count());
+    }
+};
+
+// Plays the current question and takes its answer, reading keys from
+// the first tone on: a student who knows the character need not wait
+// for the sound to end. Needs raw input (RawInput) for single keys.
+Task<Answer> askQuestion(EventLoop& loop, MorseCore::Session& session, AnswerRules rules) {
+    using Clock = std::chrono::steady_clock;
+    // Keys pressed before this question was sent belong to the last one.
+    tcflush(STDIN_FILENO, TCIFLUSH);
+    std::cout << rules.prompt;
+    std::cout.flush();
+    Answer answer;
+    [[maybe_unused]] Clock::time_point started = Clock::now();   // for the trace
+    uint64_t startFrame = queueQuestion(session);
+    uint64_t endFrame = startFrame + session.audioLength();
+    uint64_t lastToneFrame = startFrame + session.lastToneEnd();
+    bool playing = true;
+    for (;;) {
+        Clock::time_point deadline = Clock::time_point::max();
+        if (playing) {
+            // Wake when the sound should have ended and check again
+            // against a fresh device position.
+            audio().poll();
+            deadline = audio().timeOfFrame(endFrame);
+            if (Clock::now() >= deadline) {
+                playing = false;
+                CW_TRACE_COMPLETE("playback", "play question", started, deadline);
+                answer.toneEnd = audio().timeOfFrame(lastToneFrame);
+                deadline = Clock::time_point::max();
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(
-                static_cast<int>(interCharSpace)
-            ));
         }
-        else if (upperC == ' ') {
-            std::this_thread::sleep_for(std::chrono::milliseconds(
-                static_cast<int>(interWordSpace)
-            ));
+        if (!playing && rules.timeLimitSec > 0.0) {
+            deadline = answer.toneEnd + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(rules.timeLimitSec));
+        }
+        if (!co_await readable(loop, STDIN_FILENO, deadline)) {
+            if (playing) continue;
+            answer.when = Clock::now();
+            answer.expired = true;
+            co_return answer;
+        }
+        KeyPress key = readKey();
+        bool complete = key.key == 0;   // end of input
+        if (!rules.wholeLine) {
+            answer.text = std::string(1, static_cast<char>(std::tolower(static_cast<unsigned char>(key.key))));
+            complete = true;
+        } else if (key.key == '\n' || key.key == '\r') {
+            std::cout << "\n";
+            complete = true;
+        } else if (key.key == 127 || key.key == '\b') {
+            if (!answer.text.empty()) {
+                answer.text.pop_back();
+                std::cout << "\b \b";
+            }
+        } else if (std::isprint(static_cast<unsigned char>(key.key))) {
+            answer.text += key.key;
+            std::cout << key.key;
+        }
+        std::cout.flush();
+        if (!complete) continue;
+
+        answer.when = key.when;
+        if (playing) {
+            audio().poll();
+            answer.toneEnd = audio().timeOfFrame(lastToneFrame);
+            if (rules.cutShort && session.matches(answer.text)) {
+                audio().cutQueued();
+                answer.cutShort = true;
+            }
         }
+        answer.early = answer.when < answer.toneEnd;
+        CW_TRACE_COMPLETE("input", "answer", started, answer.when);
+        co_return answer;
     }
 }
 
-std::map<std::string, int> loadMissStats(const std::string &filename) {
-    std::map<std::string, int> stats;
-    std::ifstream fin(filename);
-    if (fin) {
-        std::string item;
-        int missCount;
-        while (fin >> item >> missCount) {
-            stats[item] = missCount;
-        }
-        fin.close();
-    }
-    return stats;
+MorseCore::SessionConfig makeConfig(const std::vector<MorseCore::ItemId>& pool, int numQuestions,
+                                    float pitch, int wpm, int effectiveWpm) {
+    MorseCore::SessionConfig config;
+    config.pool = pool;
+    config.numQuestions = numQuestions;
+    config.pitch = pitch;
+    config.wpm = wpm;
+    config.effectiveWpm = effectiveWpm;
+    return config;
 }
 
-void saveMissStats(const std::map<std::string, int> &stats, const std::string &filename) {
-    std::ofstream fout(filename);
-    if (fout) {
-        for (auto &entry : stats) {
-            fout << entry.first << " " << entry.second << "\n";
-        }
-        fout.close();
-    }
+// Whether a pool's answers have to be typed out to ENTER: one key
+// cannot answer a prosign or a callsign.
+bool needsWholeLine(const std::vector<MorseCore::ItemId>& pool) {
+    return std::any_of(pool.begin(), pool.end(),
+                       [](MorseCore::ItemId id) { return MorseCore::catalog().text(id).size() > 1; });
 }
 
+// Per-answer speed trajectory of adaptive sessions, for review.
+const char* const SPEED_LOG_FILE = "speed_log.csv";
+
 // --------------------
 // Morse Module Modes
 // --------------------
-void runQuizMode(float pitch, int wpm, int effectiveWpm) {
-    srand(static_cast<unsigned int>(time(nullptr)));
+Task<> runQuizMode(EventLoop& loop, float pitch, int wpm, int effectiveWpm) {
     while (true) {
         clearScreen();
         std::cout << "Choose quiz mode:\n"
@@ -232,16 +395,17 @@ void runQuizMode(float pitch, int wpm, int effectiveWpm) {
                   << "3: Mixed (letters + numbers)\n"
                   << "4: Prosigns\n"
                   << "5: Punctuation\n"
-                  << "6: Exit quiz mode\n"
-                  << "Enter your choice (1-6) ";
+                  << "6: Callsigns\n"
+                  << "7: Exit quiz mode\n"
+                  << "Enter your choice (1-7) ";
         int choice;
         std::cin >> choice;
-        if (!std::cin || choice == 6) {
+        if (!std::cin || choice == 7) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             break;
         }
-        if (choice < 1 || choice > 6) {
+        if (choice < 1 || choice > 7) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             std::cout << "Invalid choice. Press ENTER to try again.\n";
@@ -259,20 +423,17 @@ void runQuizMode(float pitch, int wpm, int effectiveWpm) {
             std::cin >> numQuestions;
         }
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-        std::vector<std::string> questionPool;
-        if (choice == 1) {
-            for (char letter : letters) questionPool.push_back(std::string(1, letter));
-        } else if (choice == 2) {
-            for (char number : numbers) questionPool.push_back(std::string(1, number));
-        } else if (choice == 3) {
-            for (char letter : letters) questionPool.push_back(std::string(1, letter));
-            for (char number : numbers) questionPool.push_back(std::string(1, number));
-        } else if (choice == 4) {
-            for (auto &p : prosigns) questionPool.push_back(p.first);
-        } else if (choice == 5) {
-            for (char punc : punctuationChars) questionPool.push_back(std::string(1, punc));
-        }
+        std::cout << "Adapt the speed to your answers? (y/n): ";
+        std::string adaptLine;
+        std::getline(std::cin, adaptLine);
+        bool adaptive = !adaptLine.empty() && std::tolower(static_cast<unsigned char>(adaptLine[0])) == 'y';
+
+        static const MorseCore::Category categories[] = {
+            MorseCore::Category::Letters, MorseCore::Category::Numbers,
+            MorseCore::Category::Mixed, MorseCore::Category::Prosigns,
+            MorseCore::Category::Punctuation, MorseCore::Category::Callsigns
+        };
+        std::vector<MorseCore::ItemId> questionPool = MorseCore::buildPool(categories[choice - 1], rng());
 
         if (numQuestions > static_cast<int>(questionPool.size())) {
             std::cout << "Warning: Only " << questionPool.size()
@@ -280,59 +441,67 @@ void runQuizMode(float pitch, int wpm, int effectiveWpm) {
             std::cin.get();
         }
 
-        std::map<std::string, int> totalAttempts;
-        std::map<std::string, int> correctAnswers;
-        std::set<std::string> usedQuestions;
-
-        for (int i = 0; i < numQuestions; ++i) {
-            clearScreen();
-            std::string question;
-            do {
-                question = questionPool[rand() % questionPool.size()];
-            } while (usedQuestions.find(question) != usedQuestions.end() &&
-                     usedQuestions.size() < questionPool.size());
-            usedQuestions.insert(question);
-            totalAttempts[question]++;
-
-            std::cout << "Question " << (i + 1) << " of " << numQuestions << ":\n\n";
-            if (choice == 4 && prosigns.find(question) != prosigns.end()) {
-                playMorseCode(prosigns[question], pitch, wpm, effectiveWpm);
-            } else {
-                playMorseCode(question, pitch, wpm, effectiveWpm);
-            }
-            std::string userInput;
-            if (choice == 4) {
-                std::cout << "\nType your answer: ";
-                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                std::getline(std::cin, userInput);
-            } else {
-                char userChar = tolower(getch());
-                userInput = std::string(1, userChar);
-            }
-            std::string questionLower = question;
-            std::string userLower     = userInput;
-            for (char &c : questionLower) c = static_cast<char>(std::tolower(c));
-            for (char &c : userLower)     c = static_cast<char>(std::tolower(c));
-            if (userLower == questionLower) {
-                correctAnswers[question]++;
+        MorseCore::Session session(makeConfig(questionPool, numQuestions, pitch, wpm, effectiveWpm));
+        MorseCore::SpeedControllerConfig speedConfig;
+        speedConfig.wpm = wpm;
+        speedConfig.effectiveWpm = effectiveWpm;
+        MorseCore::SpeedController speed(speedConfig);
+        if (adaptive)
+            session.setSpeed(speed.wpm(), speed.effectiveWpm());
+        AnswerRules rules;
+        rules.wholeLine = needsWholeLine(questionPool);
+        rules.cutShort = cutShortOnAnswer;
+        if (rules.wholeLine)
+            rules.prompt = "Type your answer and press ENTER: ";
+        {
+            RawInput raw;
+            while (!session.finished()) {
+                clearScreen();
+                session.nextQuestion();
+                std::cout << "Question " << session.questionNumber() << " of " << numQuestions;
+                if (adaptive)
+                    std::cout << " (" << session.config().wpm << " WPM, spaced at " << session.config().effectiveWpm << ")";
+                std::cout << ":\n\n";
+                Answer answer = co_await askQuestion(loop, session, rules);
+                MorseCore::Grade grade = session.submitAnswer(answer.text);
+                if (adaptive && speed.record(grade.correct, answer.responseSec()))
+                    session.setSpeed(speed.wpm(), speed.effectiveWpm());
             }
         }
 
         clearScreen();
         std::cout << "Quiz complete! Here are your results:\n\n";
+        if (adaptive) {
+            char stamp[32];
+            std::time_t now = std::time(nullptr);
+            std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+            std::cout << "Speed: started at " << wpm << " WPM spaced at " << effectiveWpm
+                      << ", finished at " << speed.wpm() << " spaced at " << speed.effectiveWpm() << ".\n";
+            if (speed.appendTrajectory(SPEED_LOG_FILE, stamp))
+                std::cout << "Speed changes logged to " << SPEED_LOG_FILE << ".\n\n";
+        }
         std::string mostMissedChar = "";
         int maxMisses = 0;
-        for (auto &entry : totalAttempts) {
-            int attempts = entry.second;
-            int correct  = correctAnswers[entry.first];
+        const MorseCore::ItemTally& items = session.stats().items;
+        // Alphabetical, as the results have always been listed.
+        std::vector<MorseCore::ItemId> asked;
+        for (MorseCore::ItemId id = 0; id < items.size(); ++id) {
+            if (items.asked[id] > 0) asked.push_back(id);
+        }
+        std::sort(asked.begin(), asked.end(), [](MorseCore::ItemId a, MorseCore::ItemId b) {
+            return MorseCore::catalog().text(a) < MorseCore::catalog().text(b);
+        });
+        for (MorseCore::ItemId id : asked) {
+            int attempts = items.asked[id];
+            int correct  = items.correct[id];
             int misses   = attempts - correct;
-            std::cout << "Item: " << entry.first
+            std::cout << "Item: " << MorseCore::catalog().text(id)
                       << " | Asked: " << attempts
                       << " | Correct: " << correct
                       << " | Missed: " << misses << "\n";
             if (misses > maxMisses) {
                 maxMisses = misses;
-                mostMissedChar = entry.first;
+                mostMissedChar = MorseCore::catalog().text(id);
             }
         }
         if (!mostMissedChar.empty() && maxMisses > 0) {
@@ -347,6 +516,90 @@ void runQuizMode(float pitch, int wpm, int effectiveWpm) {
     }
 }
 
+// How many alignment errors a grade lists before summing up the rest.
+const size_t COPY_ERRORS_SHOWN = 20;
+
+void printCopyGrade(const MorseCore::CopyGrade& grade) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "\nCharacter error rate: " << grade.charErrorRate() << "% (" << grade.charErrors
+        << " errors in " << grade.sent.size() << " characters)\n"
+        << "Word error rate: " << grade.wordErrorRate() << "% (" << grade.wordErrors
+        << " errors in " << grade.words << " words)\n";
+    for (size_t i = 0; i < grade.errors.size() && i < COPY_ERRORS_SHOWN; ++i) {
+        out << "  " << MorseCore::describeCopyError(grade, grade.errors[i]) << "\n";
+    }
+    if (grade.errors.size() > COPY_ERRORS_SHOWN) {
+        out << "  ... and " << grade.errors.size() - COPY_ERRORS_SHOWN << " more\n";
+    }
+    std::cout << out.str();
+}
+
+// Lets the student type in what they wrote down, before the answers
+// are shown, and grades it against what was sent. An empty first
+// line skips grading.
+void gradeTypedCopy(const std::string& sent) {
+    std::cout << "Type in your copy to grade it, ending with an empty line\n"
+              << "(or just press ENTER to skip):\n";
+    std::string copy;
+    {
+        CW_TRACE_SPAN("input", "typed copy");
+        std::string line;
+        while (std::getline(std::cin, line) && !line.empty()) {
+            copy += line + "\n";
+        }
+    }
+    if (!copy.empty()) {
+        printCopyGrade(MorseCore::gradeCopy(sent, copy));
+    }
+}
+
+bool askPlayAgain() {
+    std::cout << "\nWould you like to play again with the same settings? (y/n): ";
+    char response;
+    std::cin >> response;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    return std::tolower(response) == 'y';
+}
+
+// Pen-and-paper QSO copy: count generated QSOs, streamed as they are
+// made up, then the transcript. False if the corpus could not be read.
+bool copyQsos(int count, float pitch, int wpm, int effectiveWpm) {
+    MorseCore::QsoModel model;
+    if (!model.load("qso_corpus")) {
+        std::cerr << "Error: " << model.error() << "\n";
+        std::cout << "Press ENTER to return...";
+        std::cin.get();
+        return false;
+    }
+    MorseCore::QsoGenerator generator(model, rng());
+    std::vector<std::string> qsos;
+    std::cout << "Copying " << count << " QSO" << (count == 1 ? "" : "s")
+              << ". Write down what you hear.\n" << std::flush;
+    streamMorse([&]() -> std::string {
+        std::string over = generator.nextOver();
+        if (generator.startedQso()) {
+            if (static_cast<int>(qsos.size()) == count) return "";
+            qsos.emplace_back();
+        }
+        qsos.back() += over + "\n";
+        return over;
+    }, pitch, wpm, effectiveWpm);
+
+    clearScreen();
+    std::cout << "Pen-and-paper session complete!\n\n";
+    std::string sent;
+    for (const std::string& qso : qsos) {
+        sent += qso;
+    }
+    gradeTypedCopy(sent);
+    std::cout << "\nHere are the QSOs:\n";
+    for (size_t i = 0; i < qsos.size(); ++i) {
+        std::cout << "\nQSO " << (i + 1) << ":\n" << qsos[i];
+    }
+    return true;
+}
+
 void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
     clearScreen();
     int choice = 0;
@@ -358,16 +611,18 @@ void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
                   << "4. Words\n"
                   << "5. Prosigns\n"
                   << "6. Punctuation\n"
-                  << "7. Exit Pen and Paper Mode\n"
-                  << "Enter your choice (1-7) ";
+                  << "7. Callsigns\n"
+                  << "8. QSOs\n"
+                  << "9. Exit Pen and Paper Mode\n"
+                  << "Enter your choice (1-9) ";
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        if (choice == 7) {
+        if (choice == 9) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             return;
         }
-        if (std::cin && choice >= 1 && choice <= 6) {
+        if (std::cin && choice >= 1 && choice <= 8) {
             break;
         }
         std::cin.clear();
@@ -381,7 +636,8 @@ void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
     int numQuestions = 0;
     if (choice != 4) {
         clearScreen();
-        std::cout << "How many questions in this session? ";
+        std::cout << (choice == 8 ? "How many QSOs in this session? "
+                                  : "How many questions in this session? ");
         while (!(std::cin >> numQuestions) || numQuestions <= 0) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -394,103 +650,75 @@ void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
     bool playAgain = true;
     while (playAgain) {
         clearScreen();
-        std::vector<std::string> questionPool;
+        if (choice == 8) {
+            if (!copyQsos(numQuestions, pitch, wpm, effectiveWpm)) {
+                return;
+            }
+            playAgain = askPlayAgain();
+            continue;
+        }
+        std::vector<MorseCore::ItemId> questionPool;
 
         if (choice == 1) {
-            // Letters
-            for (char letter : letters) 
-                questionPool.push_back(std::string(1, letter));
-
+            questionPool = MorseCore::buildPool(MorseCore::Category::Letters);
         } else if (choice == 2) {
-            // Numbers
-            for (char number : numbers) 
-                questionPool.push_back(std::string(1, number));
-
+            questionPool = MorseCore::buildPool(MorseCore::Category::Numbers);
         } else if (choice == 3) {
-            // Letters + Numbers
-            for (char letter : letters) 
-                questionPool.push_back(std::string(1, letter));
-            for (char number : numbers) 
-                questionPool.push_back(std::string(1, number));
-
+            questionPool = MorseCore::buildPool(MorseCore::Category::Mixed);
         } else if (choice == 4) {
             // Words
-            std::ifstream infile("wordlist");
-            if (!infile) {
-                std::cerr << "Error: Could not open file 'wordlist'.\n";
+            std::vector<std::string> words = MorseCore::loadWordlist("wordlist");
+            if (words.empty()) {
+                std::cerr << "Error: Could not read any words from 'wordlist'.\n";
             } else {
-                std::vector<std::string> words;
-                std::string line;
-                while (std::getline(infile, line)) {
-                    if (!line.empty())
-                        words.push_back(line);
+                int letterCount = 0;
+                std::cout << "Enter the number of letters each word should have: ";
+                while (!(std::cin >> letterCount) || letterCount <= 0) {
+                    std::cin.clear();
+                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    std::cout << "Invalid input. Please enter a positive integer: ";
                 }
-                infile.close();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-                if (words.empty()) {
-                    std::cout << "No words found in the file.\n";
+                std::vector<std::string> filtered = MorseCore::filterWords(words, letterCount, false);
+                if (filtered.empty()) {
+                    std::cout << "No words with exactly " 
+                              << letterCount << " letters were found.\n";
                 } else {
-                    int letterCount = 0;
-                    std::cout << "Enter the number of letters each word should have: ";
-                    while (!(std::cin >> letterCount) || letterCount <= 0) {
+                    // Now ask how many words they want to study:
+                    int numWords;
+                    std::cout << "How many words do you want to study? ";
+                    while (!(std::cin >> numWords) || numWords <= 0) {
                         std::cin.clear();
                         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
                         std::cout << "Invalid input. Please enter a positive integer: ";
                     }
                     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-                    // Filter words
-                    std::vector<std::string> filtered;
-                    for (const auto &word : words) {
-                        if (static_cast<int>(word.size()) == letterCount)
-                            filtered.push_back(word);
+                    if (numWords > static_cast<int>(filtered.size())) {
+                        std::cout << "Only " << filtered.size() << " words available with " 
+                                  << letterCount << " letters. Using all available words.\n";
+                        numWords = filtered.size();
                     }
-                    if (filtered.empty()) {
-                        std::cout << "No words with exactly " 
-                                  << letterCount << " letters were found.\n";
-                    } else {
-                        // Now ask how many words they want to study:
-                        int numWords;
-                        std::cout << "How many words do you want to study? ";
-                        while (!(std::cin >> numWords) || numWords <= 0) {
-                            std::cin.clear();
-                            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                            std::cout << "Invalid input. Please enter a positive integer: ";
-                        }
-                        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    // Shuffle the filtered words:
+                    std::shuffle(filtered.begin(), filtered.end(), rng);
 
-                        if (numWords > static_cast<int>(filtered.size())) {
-                            std::cout << "Only " << filtered.size() << " words available with " 
-                                      << letterCount << " letters. Using all available words.\n";
-                            numWords = filtered.size();
-                        }
-                        // Shuffle the filtered words:
-                        std::random_device rd;
-                        std::mt19937 gen(rd());
-                        std::shuffle(filtered.begin(), filtered.end(), gen);
-
-                        // Add them to the question pool
-                        for (int i = 0; i < numWords; i++) {
-                            questionPool.push_back(filtered[i]);
-                        }
+                    // Add them to the question pool
+                    for (int i = 0; i < numWords; i++) {
+                        questionPool.push_back(MorseCore::catalog().intern(filtered[i]));
                     }
                 }
             }
 
         } else if (choice == 5) {
-            // Prosigns
-            for (auto &p : prosigns) {
-                questionPool.push_back(p.first);
-            }
-
+            questionPool = MorseCore::buildPool(MorseCore::Category::Prosigns);
         } else if (choice == 6) {
-            // Punctuation
-            for (char punc : punctuationChars) {
-                questionPool.push_back(std::string(1, punc));
-            }
+            questionPool = MorseCore::buildPool(MorseCore::Category::Punctuation);
+        } else if (choice == 7) {
+            questionPool = MorseCore::buildPool(MorseCore::Category::Callsigns, rng());
         }
 
-        // If user chose 1/2/3/5/6 but typed in a large numQuestions:
+        // If user chose 1/2/3/5/6/7 but typed in a large numQuestions:
         if (choice != 4 && 
             numQuestions > static_cast<int>(questionPool.size())) {
             std::cout << "Warning: Only " << questionPool.size()
@@ -498,7 +726,6 @@ void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
             std::cin.get();
         }
 
-        std::set<std::string> usedQuestions;
         std::vector<std::string> correctAnswers;
 
         // If user picked #4, how many "questions" do we do?
@@ -507,40 +734,24 @@ void runPenAndPaperMode(float pitch, int wpm, int effectiveWpm) {
             ? static_cast<int>(questionPool.size())
             : numQuestions;
 
-        for (int i = 0; i < totalToPlay; ++i) {
-            std::string question;
-            if (!questionPool.empty()) {
-                do {
-                    question = questionPool[rand() % questionPool.size()];
-                } while (
-                    usedQuestions.find(question) != usedQuestions.end() &&
-                    usedQuestions.size() < questionPool.size()
-                );
-                usedQuestions.insert(question);
-                correctAnswers.push_back(question);
-
-                if (prosigns.find(question) != prosigns.end()) {
-                    playMorseCode(prosigns[question], pitch, wpm, effectiveWpm);
-                } else {
-                    playMorseCode(question, pitch, wpm, effectiveWpm);
-                }
-            }
+        MorseCore::Session session(makeConfig(questionPool, totalToPlay, pitch, wpm, effectiveWpm));
+        while (!session.finished()) {
+            correctAnswers.push_back(session.nextQuestion());
+            playQuestion(session);
         }
 
         clearScreen();
-        std::cout << "Pen-and-paper session complete!\n\n"
-                  << "Here are the answers:\n\n";
+        std::cout << "Pen-and-paper session complete!\n\n";
+        std::string sent;
+        for (const std::string& answer : correctAnswers) {
+            sent += answer + " ";
+        }
+        gradeTypedCopy(sent);
+        std::cout << "\nHere are the answers:\n\n";
         for (size_t i = 0; i < correctAnswers.size(); ++i) {
             std::cout << (i + 1) << ". " << correctAnswers[i] << "\n";
         }
-
-        std::cout << "\nWould you like to play again with the same settings? (y/n): ";
-        char response;
-        std::cin >> response;
-        if (std::tolower(response) != 'y') {
-            playAgain = false;
-        }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        playAgain = askPlayAgain();
     }
     clearScreen();
     std::cout << "Returning to the main menu...\n";
@@ -568,27 +779,28 @@ void runSingleCharacterMode(float pitch, int wpm, int effectiveWpm) {
             ch = static_cast<char>(std::toupper(ch));
         }
         bool didPlay = false;
+        const MorseCore::ItemCatalog& items = MorseCore::catalog();
+        MorseCore::ItemId id = items.find(input);
+        bool known = id != MorseCore::NO_ITEM && (items.kind(id) == MorseCore::ItemKind::Character ||
+                                                  items.kind(id) == MorseCore::ItemKind::Prosign);
         if (input.size() == 1) {
             char c = input[0];
-            auto it = morseCode.find(c);
-            if (it != morseCode.end()) {
-                playMorseCode(std::string(1, c), pitch, wpm, effectiveWpm);
-                std::cout << "\nPlayed character: " << c << "\n";
+            if (known) {
+                playMorseCode(items.sendingText(id), pitch, wpm, effectiveWpm);
+                std::cout << "\nPlayed character: " << c << "  " << items.code(id) << "\n";
                 didPlay = true;
             } else {
                 std::cout << "\nNo Morse mapping for '" << c << "'\n";
             }
         } else {
-            auto pit = prosigns.find(input);
-            if (pit != prosigns.end()) {
-                playMorseCode(pit->second, pitch, wpm, effectiveWpm);
-                std::cout << "\nPlayed prosign: " << input << "\n";
+            if (known) {
+                playMorseCode(items.sendingText(id), pitch, wpm, effectiveWpm);
+                std::cout << "\nPlayed prosign: " << input << "  " << items.code(id) << "\n";
                 didPlay = true;
             } else {
                 std::cout << "\nNot a recognized prosign. Will attempt to play each char individually...\n";
                 for (char c : input) {
-                    auto it = morseCode.find(c);
-                    if (it != morseCode.end()) {
+                    if (MorseCore::lookup(c)) {
                         playMorseCode(std::string(1, c), pitch, wpm, effectiveWpm);
                         std::cout << "Played: " << c << "\n";
                         didPlay = true;
@@ -608,11 +820,12 @@ void runSingleCharacterMode(float pitch, int wpm, int effectiveWpm) {
     std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
-void runLessonsMode(float pitch, int wpm, int effectiveWpm) {
+Task<> runLessonsMode(EventLoop& loop, float pitch, int wpm, int effectiveWpm) {
     clearScreen();
     std::cout << "Welcome to Lesson Mode (Progressive Learning)\n\n";
     std::cout << "In each lesson, you'll practice a small group of letters.\n"
               << "We'll quiz you, and if you pass, you move to the next group.\n\n";
+    const std::vector<std::vector<char>>& letterGroups = MorseCore::letterGroups();
     std::vector<std::string> missedAllLessons;
     for (size_t lessonIndex = 0; lessonIndex < letterGroups.size(); ++lessonIndex) {
         clearScreen();
@@ -624,44 +837,38 @@ void runLessonsMode(float pitch, int wpm, int effectiveWpm) {
         }
         std::cout << "\nPress ENTER to begin the quiz.\n";
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        std::vector<std::string> questionPool;
+        std::vector<MorseCore::ItemId> questionPool;
         for (char c : letterGroups[lessonIndex]) {
-            questionPool.push_back(std::string(1, c));
+            questionPool.push_back(MorseCore::catalog().character(c));
         }
         int numQuestions = 25;
-        int correctCount = 0;
-        std::set<std::string> usedThisLesson;
-        srand(static_cast<unsigned int>(time(nullptr)));
-        for (int i = 0; i < numQuestions; ++i) {
-            clearScreen();
-            std::cout << "Lesson " << (lessonIndex + 1) << "/"
-                      << letterGroups.size()
-                      << " | Question " << (i + 1)
-                      << " of " << numQuestions << "\n\n";
-            std::string question;
-            do {
-                question = questionPool[rand() % questionPool.size()];
-            } while (usedThisLesson.find(question) != usedThisLesson.end() &&
-                     usedThisLesson.size() < questionPool.size());
-            usedThisLesson.insert(question);
-            playMorseCode(question, pitch, wpm, effectiveWpm);
-            std::cout << "\nEnter your single-character answer: ";
-            std::cout.flush();
-            char userChar = tolower(getch());
-            std::string userInput(1, userChar);
-            std::cout << userInput << "\n";
-            std::string questionLower = question;
-            for (char &c : questionLower) c = static_cast<char>(std::tolower(c));
-            for (char &c : userInput)     c = static_cast<char>(std::tolower(c));
-            if (userInput == questionLower) {
-                std::cout << "Correct!\n";
-                correctCount++;
-            } else {
-                std::cout << "Incorrect. Correct answer was: " << question << "\n";
-                missedAllLessons.push_back(question);
+        MorseCore::Session session(makeConfig(questionPool, numQuestions, pitch, wpm, effectiveWpm));
+        AnswerRules rules;
+        rules.cutShort = cutShortOnAnswer;
+        rules.prompt = "\nEnter your single-character answer: ";
+        {
+            RawInput raw;
+            while (!session.finished()) {
+                clearScreen();
+                session.nextQuestion();
+                std::cout << "Lesson " << (lessonIndex + 1) << "/"
+                          << letterGroups.size()
+                          << " | Question " << session.questionNumber()
+                          << " of " << numQuestions << "\n\n";
+                Answer answer = co_await askQuestion(loop, session, rules);
+                std::cout << answer.text << "\n";
+                MorseCore::Grade grade = session.submitAnswer(answer.text);
+                if (grade.correct) {
+                    std::cout << "Correct!\n";
+                } else {
+                    std::cout << "Incorrect. Correct answer was: " << grade.expected << "\n";
+                    missedAllLessons.push_back(grade.expected);
+                }
+                std::cout.flush();
+                co_await sleepFor(loop, std::chrono::seconds(2));
             }
-            std::this_thread::sleep_for(std::chrono::seconds(2));
         }
+        int correctCount = session.stats().correct;
         double scorePercent = 100.0 * correctCount / numQuestions;
         clearScreen();
         std::cout << "Lesson " << (lessonIndex + 1) << " complete!\n\n"
@@ -689,10 +896,24 @@ void runLessonsMode(float pitch, int wpm, int effectiveWpm) {
         }
     }
     std::cout << "\nReturning to the main menu...\n";
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    std::cout.flush();
+    co_await sleepFor(loop, std::chrono::seconds(2));
+}
+
+// Category for the "1. Letters 2. Numbers 3. Punctuation 4. Prosigns
+// 5. Callsigns" study menu shared by the speed challenge and
+// spaced-repetition modes.
+MorseCore::Category studyCategory(int selection) {
+    switch (selection) {
+        case 2:  return MorseCore::Category::Numbers;
+        case 3:  return MorseCore::Category::Punctuation;
+        case 4:  return MorseCore::Category::Prosigns;
+        case 5:  return MorseCore::Category::Callsigns;
+        default: return MorseCore::Category::Letters;
+    }
 }
 
-void runSpeedChallengeMode(float pitch, int wpm, int effectiveWpm) {
+Task<> runSpeedChallengeMode(EventLoop& loop, float pitch, int wpm, int effectiveWpm) {
     clearScreen();
     std::cout << "Speed Challenge Mode!\n";
     //std::cin.clear();
@@ -704,9 +925,10 @@ void runSpeedChallengeMode(float pitch, int wpm, int effectiveWpm) {
                   << "2. Numbers\n"
                   << "3. Punctuation\n"
                   << "4. Prosigns\n"
-                  << "Enter your choice (1-4): ";
+                  << "5. Callsigns\n"
+                  << "Enter your choice (1-5): ";
         std::cin >> selection;
-        if (std::cin && selection >= 1 && selection <= 4) {
+        if (std::cin && selection >= 1 && selection <= 5) {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             break;
         }
@@ -734,72 +956,65 @@ void runSpeedChallengeMode(float pitch, int wpm, int effectiveWpm) {
         std::cin >> timeLimitSeconds;
     }
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::vector<std::string> questionPool;
-    switch (selection) {
-        case 1:
-            for (char letter : letters) {
-                questionPool.push_back(std::string(1, letter));
+    std::vector<MorseCore::ItemId> questionPool = MorseCore::buildPool(studyCategory(selection), rng());
+    MorseCore::SessionConfig config = makeConfig(questionPool, numQuestions, pitch, wpm, effectiveWpm);
+    config.selection = MorseCore::Selection::Random;
+    config.timeLimitSec = timeLimitSeconds;
+    MorseCore::Session session(config);
+    // Answer time runs from the moment the final element leaves the
+    // sound card (per the device's reported position), and the
+    // question expires at that moment plus the time limit. An answer
+    // typed while the sound is still playing counts as instant.
+    AnswerRules rules;
+    rules.wholeLine = needsWholeLine(questionPool);
+    rules.timeLimitSec = timeLimitSeconds;
+    rules.cutShort = cutShortOnAnswer;
+    {
+        std::ostringstream prompt;
+        if (rules.wholeLine)
+            prompt << "\nType your answer and press ENTER before " << timeLimitSeconds << " seconds pass!\n";
+        else
+            prompt << "\nPress your single-character answer before " << timeLimitSeconds << " seconds pass!\n";
+        rules.prompt = prompt.str();
+    }
+    {
+        RawInput raw;
+        while (!session.finished()) {
+            clearScreen();
+            session.nextQuestion();
+            std::cout << "Speed Challenge - Question " << session.questionNumber()
+                      << " of " << numQuestions << "\n\n";
+            Answer answer = co_await askQuestion(loop, session, rules);
+            if (answer.expired) {
+                MorseCore::Grade grade = session.expire(answer.text);
+                std::cout << "\nTIME'S UP!\n"
+                          << "The correct answer was: " << grade.expected << "\n";
+                std::cout.flush();
+                co_await sleepFor(loop, std::chrono::seconds(2));
+                continue;
             }
-            break;
-        case 2:
-            for (char number : numbers) {
-                questionPool.push_back(std::string(1, number));
+            double elapsed = answer.responseSec();
+            std::cout << "\nYou typed: " << answer.text << "\n"
+                      << "Time taken: " << elapsed << " seconds"
+                      << (answer.early ? " (answered during the sound)" : "") << "\n";
+            MorseCore::Grade grade = session.submitAnswer(answer.text, elapsed);
+            if (grade.timedOut) {
+                std::cout << "TIME'S UP!\n";
             }
-            break;
-        case 3:
-            for (char punc : punctuationChars) {
-                questionPool.push_back(std::string(1, punc));
+            if (grade.correct) {
+                std::cout << "Correct!\n";
             }
-            break;
-        case 4:
-            for (auto &p : prosigns) {
-                questionPool.push_back(p.first);
+            else if (grade.matched) {
+                std::cout << "You got the right answer, but you're out of time!\n";
+            } else {
+                std::cout << "Wrong answer. The correct answer was: " << grade.expected << "\n";
             }
-            break;
-    }
-    int correctCount  = 0;
-    int timedOutCount = 0;  
-    srand(static_cast<unsigned int>(time(nullptr)));
-    for (int i = 1; i <= numQuestions; ++i) {
-        clearScreen();
-        std::cout << "Speed Challenge - Question " << i
-                  << " of " << numQuestions << "\n\n";
-        std::string question = questionPool[rand() % questionPool.size()];
-        if (selection == 4 && prosigns.find(question) != prosigns.end()) {
-            playMorseCode(prosigns[question], pitch, wpm, effectiveWpm);
-        } else {
-            playMorseCode(question, pitch, wpm, effectiveWpm);
-        }
-        auto startTime = std::chrono::high_resolution_clock::now();
-        std::cout << "\nPress your single-character answer before "
-                  << timeLimitSeconds << " seconds pass!\n";
-        std::cout.flush();
-        char userChar = tolower(getch());
-        auto endTime = std::chrono::high_resolution_clock::now();
-        double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                             endTime - startTime).count() / 1000.0;
-        std::string userInput(1, userChar);
-        std::cout << "\nYou typed: " << userInput << "\n"
-                  << "Time taken: " << elapsed << " seconds\n";
-        bool isTimedOut = (elapsed > timeLimitSeconds);
-        if (isTimedOut) {
-            std::cout << "TIME'S UP!\n";
-            timedOutCount++;
-        }
-        std::string questionLower = question;
-        for (char &c : questionLower) c = static_cast<char>(std::tolower(c));
-        for (char &c : userInput)    c = static_cast<char>(std::tolower(c));
-        if (userInput == questionLower && !isTimedOut) {
-            correctCount++;
-            std::cout << "Correct!\n";
-        }
-        else if (userInput == questionLower && isTimedOut) {
-            std::cout << "You got the right answer, but you're out of time!\n";
-        } else {
-            std::cout << "Wrong answer. The correct answer was: " << question << "\n";
+            std::cout.flush();
+            co_await sleepFor(loop, std::chrono::seconds(2));
         }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
     }
+    int correctCount  = session.stats().correct;
+    int timedOutCount = session.stats().timedOut;
     clearScreen();
     std::cout << "Speed Challenge Complete!\n\n"
               << "Questions: " << numQuestions << "\n"
@@ -814,7 +1029,7 @@ void runSpeedChallengeMode(float pitch, int wpm, int effectiveWpm) {
     std::cin.get();
 }
 
-void runSpacedRepetitionQuiz(float pitch, int wpm, int effectiveWpm) {
+Task<> runSpacedRepetitionQuiz(EventLoop& loop, float pitch, int wpm, int effectiveWpm) {
     clearScreen();
     //std::cout << "Spaced-Repetition Quiz Mode\n\n";
     //std::cin.clear();
@@ -826,9 +1041,10 @@ void runSpacedRepetitionQuiz(float pitch, int wpm, int effectiveWpm) {
                   << "2. Numbers\n"
                   << "3. Punctuation\n"
                   << "4. Prosigns\n"
-                  << "Enter your choice (1-4) ";
+                  << "5. Callsigns\n"
+                  << "Enter your choice (1-5) ";
         std::cin >> selection;
-        if (std::cin && selection >= 1 && selection <= 4) {
+        if (std::cin && selection >= 1 && selection <= 5) {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             break;
         }
@@ -847,86 +1063,37 @@ void runSpacedRepetitionQuiz(float pitch, int wpm, int effectiveWpm) {
         std::cin >> numQuestions;
     }
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::map<std::string, int> persistentMisses = loadMissStats("misses.txt");
-    std::vector<std::string> masterPool;
-    switch (selection) {
-        case 1:
-            for (char letter : letters) {
-                masterPool.push_back(std::string(1, letter));
-            }
-            break;
-        case 2:
-            for (char number : numbers) {
-                masterPool.push_back(std::string(1, number));
-            }
-            break;
-        case 3:
-            for (char punc : punctuationChars) {
-                masterPool.push_back(std::string(1, punc));
-            }
-            break;
-        case 4:
-            for (auto &p : prosigns) {
-                masterPool.push_back(p.first);
-            }
-            break;
-    }
-    for (auto &item : masterPool) {
-        if (persistentMisses.find(item) == persistentMisses.end()) {
-            persistentMisses[item] = 0;
-        }
-    }
-    srand(static_cast<unsigned int>(time(nullptr)));
-    int quizMissCount = 0;
-    for (int q = 1; q <= numQuestions; ++q) {
-        clearScreen();
-        std::cout << "Spaced-Repetition Quiz - Question " << q
-                  << " of " << numQuestions << "\n\n";
-        long long totalWeight = 0;
-        for (auto &entry : persistentMisses) {
-            if (std::find(masterPool.begin(), masterPool.end(), entry.first) == masterPool.end()) {
-                continue;
-            }
-            totalWeight += (1 + entry.second);
-        }
-        long long r = rand() % totalWeight;
-        std::string question;
-        long long cumulative = 0;
-        for (auto &entry : persistentMisses) {
-            if (std::find(masterPool.begin(), masterPool.end(), entry.first) == masterPool.end()) {
-                continue;
-            }
-            cumulative += (1 + entry.second);
-            if (r < cumulative) {
-                question = entry.first;
-                break;
+    MorseCore::ItemTally persistentMisses = MorseCore::loadMissStats("misses.txt");
+    std::vector<MorseCore::ItemId> questionPool = MorseCore::buildPool(studyCategory(selection), rng());
+    MorseCore::SessionConfig config = makeConfig(questionPool, numQuestions, pitch, wpm, effectiveWpm);
+    config.selection = MorseCore::Selection::Weighted;
+    MorseCore::Session session(config, &persistentMisses);
+    AnswerRules rules;
+    rules.wholeLine = needsWholeLine(questionPool);
+    rules.cutShort = cutShortOnAnswer;
+    rules.prompt = rules.wholeLine ? "\nType your answer and press ENTER: "
+                                   : "\nEnter your single-character answer: ";
+    {
+        RawInput raw;
+        while (!session.finished()) {
+            clearScreen();
+            session.nextQuestion();
+            std::cout << "Spaced-Repetition Quiz - Question " << session.questionNumber()
+                      << " of " << numQuestions << "\n\n";
+            Answer answer = co_await askQuestion(loop, session, rules);
+            if (!rules.wholeLine)
+                std::cout << answer.text << "\n";   // typed lines echo as they go
+            MorseCore::Grade grade = session.submitAnswer(answer.text);
+            if (grade.correct) {
+                std::cout << "Correct!\n";
+            } else {
+                std::cout << "Incorrect. Correct answer was: " << grade.expected << "\n";
             }
+            std::cout.flush();
+            co_await sleepFor(loop, std::chrono::seconds(2));
         }
-        if (question.empty() && !masterPool.empty()) {
-            question = masterPool[rand() % masterPool.size()];
-        }
-        if (selection == 4 && prosigns.find(question) != prosigns.end()) {
-            playMorseCode(prosigns[question], pitch, wpm, effectiveWpm);
-        } else {
-            playMorseCode(question, pitch, wpm, effectiveWpm);
-        }
-        std::cout << "\nEnter your single-character answer: ";
-        std::cout.flush();
-        char userChar = tolower(getch());
-        std::string userInput(1, userChar);
-        std::cout << userInput << "\n";
-        std::string questionLower = question;
-        for (char &c : questionLower) c = static_cast<char>(std::tolower(c));
-        for (char &c : userInput)    c = static_cast<char>(std::tolower(c));
-        if (questionLower == userInput) {
-            std::cout << "Correct!\n";
-        } else {
-            std::cout << "Incorrect. Correct answer was: " << question << "\n";
-            persistentMisses[question]++;
-            quizMissCount++;
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
     }
+    int quizMissCount = session.stats().asked - session.stats().correct;
     clearScreen();
     std::cout << "Spaced-Repetition Quiz Complete!\n\n";
     if (quizMissCount > 0) {
@@ -937,12 +1104,13 @@ void runSpacedRepetitionQuiz(float pitch, int wpm, int effectiveWpm) {
         std::cout << "Great job! You didn't miss any this session.\n\n";
     }
     std::cout << "Saving updated stats to 'misses.txt'...\n";
-    saveMissStats(persistentMisses, "misses.txt");
+    MorseCore::saveMissStats(persistentMisses, "misses.txt");
     std::cout << "\nAll-time characters missed (per 'misses.txt'):\n";
     bool anyMissedOverall = false;
-    for (auto &entry : persistentMisses) {
-        if (entry.second > 0) {
-            std::cout << "  " << entry.first << " missed " << entry.second << " times total.\n";
+    for (MorseCore::ItemId id = 0; id < persistentMisses.size(); ++id) {
+        if (persistentMisses.missed[id] > 0) {
+            std::cout << "  " << MorseCore::catalog().text(id) << " missed "
+                      << persistentMisses.missed[id] << " times total.\n";
             anyMissedOverall = true;
         }
     }
@@ -954,22 +1122,154 @@ void runSpacedRepetitionQuiz(float pitch, int wpm, int effectiveWpm) {
     std::cin.get();
 }
 
-// --- Wrap the original Morse10.cpp main loop as a function ---
-void morseMain() {
-    addPunctuation();
-    for (char c = 'A'; c <= 'Z'; ++c) {
-        letters.push_back(c);
+// What follow mode does with text that is written faster than it can
+// be sent. Under either policy the backlog is capped: once the unsent
+// lines would take longer than the limit, the oldest are skipped.
+enum class FollowPolicy { Drop, SpeedUp };
+
+// Under SpeedUp the speed grows with the backlog, reaching this
+// multiple of the chosen speed as the backlog reaches the limit.
+const double FOLLOW_MAX_SPEEDUP = 2.0;
+
+// Sends each line another program appends to a text file, tail -f
+// style. Only a quarter second of audio is queued past the speaker;
+// the rest waits as text, where the policy can still act on it. With
+// nothing playing the queue is empty, so a new line starts a period
+// or two after it is written, well inside one element.
+void followFile(const std::string& path, FollowPolicy policy, double maxBacklogSec,
+                float pitch, int wpm, int effectiveWpm) {
+    TextFollower follower;
+    if (!follower.open(path)) {
+        std::cout << follower.error() << "\n";
+        return;
     }
-    for (char c = '0'; c <= '9'; ++c) {
-        numbers.push_back(c);
+    const MorseCore::Timing timing = MorseCore::makeTiming(wpm, effectiveWpm);
+    const uint64_t lead = MorseCore::SAMPLE_RATE / 4;
+    struct Line {
+        std::string text;
+        double seconds;   // at the chosen speed
+    };
+    std::deque<Line> backlog;
+    double backlogSec = 0.0;
+    size_t skipped = 0;
+    MorseCore::MessageRenderer renderer;
+    std::vector<short> period(1024);
+    uint64_t end = 0;
+    EventLoop loop;
+    EventLoop::TimerId timer = -1;
+
+    // Tops the engine's queue up to `lead` and comes back when half of
+    // it has played.
+    std::function<void()> pump = [&] {
+        timer = -1;
+        AudioEngine& engine = audio();
+        engine.poll();
+        uint64_t now = engine.playbackFrame();
+        while (end < now + lead) {
+            size_t n = renderer.render(period.data(), period.size());
+            if (n > 0) {
+                end = engine.enqueue(period.data(), n) + n;
+                continue;
+            }
+            if (backlog.empty()) break;
+            double speedup = 1.0;
+            if (policy == FollowPolicy::SpeedUp)
+                speedup = std::min(FOLLOW_MAX_SPEEDUP, 1.0 + (FOLLOW_MAX_SPEEDUP - 1.0) * backlogSec / maxBacklogSec);
+            Line line = std::move(backlog.front());
+            backlog.pop_front();
+            backlogSec -= line.seconds;
+            int lineWpm = static_cast<int>(std::lround(wpm * speedup));
+            int lineEffective = static_cast<int>(std::lround(effectiveWpm * speedup));
+            renderer = MorseCore::MessageRenderer(line.text + " ", pitch,
+                                                  MorseCore::makeTiming(lineWpm, lineEffective));
+            if (skipped > 0) {
+                std::cout << "[skipped " << skipped << " line" << (skipped == 1 ? "" : "s") << "]\n";
+                skipped = 0;
+            }
+            if (lineWpm != wpm)
+                std::cout << "[" << lineWpm << " WPM] ";
+            std::cout << line.text << "\n";
+            std::cout.flush();
+        }
+        if (!renderer.done() || !backlog.empty()) {
+            uint64_t wake = end > lead / 2 ? end - lead / 2 : 0;
+            timer = loop.addTimer(engine.timeOfFrame(wake), [&] { pump(); });
+        }
+    };
+
+    bool following = follower.start(loop, [&](const std::string& text) {
+        if (std::none_of(text.begin(), text.end(), [](char c) { return MorseCore::lookup(c) != nullptr; }))
+            return;
+        double seconds = static_cast<double>(MorseCore::messageLength(text + " ", timing)) / MorseCore::SAMPLE_RATE;
+        backlog.push_back({text, seconds});
+        backlogSec += seconds;
+        while (backlogSec > maxBacklogSec && backlog.size() > 1) {
+            backlogSec -= backlog.front().seconds;
+            backlog.pop_front();
+            ++skipped;
+        }
+        if (timer < 0)
+            pump();
+    });
+    if (!following) {
+        std::cout << follower.error() << "\n";
+        return;
     }
-    float pitch = 800.0f;
+
+    clearScreen();
+    std::cout << "Following " << path << "; each new line is sent as it is written.\n"
+              << "Press q to stop.\n\n";
+    std::cout.flush();
+    RawInput raw;
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c = readKey().key;
+        if (c == 'q' || c == 'Q' || c == 0)
+            loop.stop();
+    });
+    loop.run();
+    follower.stop();
+    if (timer >= 0)
+        loop.cancelTimer(timer);
+    if (end > 0)
+        audio().waitForFrame(end);
+}
+
+void runFollowMode(float pitch, int wpm, int effectiveWpm) {
+    clearScreen();
+    std::cout << "Follow a text file\n"
+              << "File to follow: ";
+    std::string path;
+    std::getline(std::cin, path);
+    if (path.empty())
+        return;
+    std::cout << "When text comes faster than it can be sent:\n"
+              << "1) skip to the newest lines\n"
+              << "2) speed up, up to " << FOLLOW_MAX_SPEEDUP << "x\n"
+              << "Choice [1]: ";
+    std::string line;
+    std::getline(std::cin, line);
+    FollowPolicy policy = line == "2" ? FollowPolicy::SpeedUp : FollowPolicy::Drop;
+    std::cout << "Most unsent text to hold, in seconds of Morse [30]: ";
+    std::getline(std::cin, line);
+    double maxBacklogSec = 30.0;
+    try { maxBacklogSec = std::stod(line); } catch (...) { maxBacklogSec = 30.0; }
+    if (maxBacklogSec <= 0.0)
+        maxBacklogSec = 30.0;
+    followFile(path, policy, maxBacklogSec, pitch, wpm, effectiveWpm);
+    std::cout << "\nPress ENTER to continue...";
+    std::cin.get();
+}
+
+// --- Wrap the original Morse10.cpp main loop as a function ---
+void morseMain() {
+    float pitch = tonePitch;
     int wpm = 20;
     int effectiveWpm = 10;
     clearScreen();
     std::cout << "Practice Morse Code\n";
     std::cout << "Enter pitch (Hz), e.g. 800: ";
     std::cin >> pitch;
+    tonePitch = pitch;
     std::cout << "Enter character speed (WPM), e.g. 20: ";
     std::cin >> wpm;
     std::cout << "Enter Farnsworth speed (WPM), e.g. 10: ";
@@ -979,6 +1279,10 @@ void morseMain() {
         effectiveWpm = wpm;
     }
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::cout << "Stop the sound as soon as you answer correctly? (y/n): ";
+    std::string cutLine;
+    std::getline(std::cin, cutLine);
+    cutShortOnAnswer = !cutLine.empty() && std::tolower(static_cast<unsigned char>(cutLine[0])) == 'y';
     while (true) {
         clearScreen();
         std::cout << "Choose an option:\n"
@@ -989,8 +1293,9 @@ void morseMain() {
                   << "5: Spaced-Repetition Quiz\n"
                   << "6: Lessons Mode (Progressive)\n"
                   << "7: Speed Challenge Mode\n"
-                  << "8: Return to Main Menu\n"
-                  << "Enter your choice (1-8) ";
+                  << "8: Follow a Text File\n"
+                  << "9: Return to Main Menu\n"
+                  << "Enter your choice (1-9) ";
                   
         int choice=0;
         std::cin >> choice;
@@ -999,7 +1304,7 @@ void morseMain() {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             continue;
         }
-        if (choice == 8) {
+        if (choice == 9) {
             break;
         }
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -1012,17 +1317,19 @@ void morseMain() {
             std::cout << "\nPress ENTER to continue...";
             std::cin.get();
         } else if (choice == 2) {
-            runQuizMode(pitch, wpm, effectiveWpm);
+            runTask(modeLoop(), runQuizMode(modeLoop(), pitch, wpm, effectiveWpm));
         } else if (choice == 3) {
             runPenAndPaperMode(pitch, wpm, effectiveWpm);
         } else if (choice == 4) {
             runSingleCharacterMode(pitch, wpm, effectiveWpm);
         } else if (choice == 5) {
-            runSpacedRepetitionQuiz(pitch, wpm, effectiveWpm);
+            runTask(modeLoop(), runSpacedRepetitionQuiz(modeLoop(), pitch, wpm, effectiveWpm));
         } else if (choice == 6) {
-            runLessonsMode(pitch, wpm, effectiveWpm);
+            runTask(modeLoop(), runLessonsMode(modeLoop(), pitch, wpm, effectiveWpm));
         } else if (choice == 7) {
-            runSpeedChallengeMode(pitch, wpm, effectiveWpm);
+            runTask(modeLoop(), runSpeedChallengeMode(modeLoop(), pitch, wpm, effectiveWpm));
+        } else if (choice == 8) {
+            runFollowMode(pitch, wpm, effectiveWpm);
         } else {
             std::cout << "Invalid choice. Try again.\n";
         }
@@ -1037,44 +1344,37 @@ void morseMain() {
 namespace WinKeyerModule {
 
 volatile bool running = true;
-int currentWPM = 20;
-int speedPotMinWpm = 5;
-int speedPotMaxWpm = 35;
-bool useBufferedSpeedChange = false;
-bool internalSpeakerOn = true;
-unsigned char pinCfg = 0x0F; // internal speaker on
-static const int POLL_USEC = 10000; // 10 ms poll
-static const double GRACE_SEC = 0.05; // 50 ms
+std::vector<std::string> devicePaths = {"/dev/ttyUSB0"};
+const std::string PROFILES_FILE = "keyer_profiles.txt";
+std::string startupProfile = "default";   // applied at connect if saved
+
+// Everything the module knows about one keyer. The menus and practice
+// loops work on one of these; the classroom runs one per student.
+struct Keyer {
+    std::string device;
+    WinKeyerPort port;
+    WinKeyerCore::KeyerSettings settings;
+};
 
 void sigint_handler(int) {
     running = false;
 }
 
 void clearScreen() {
-    std::cout << "\033[2J\033[H";
-    std::cout.flush();
+    terminal().clearScreen();
 }
 
-bool writeBytes(int fd, const unsigned char* data, size_t length) {
-    ssize_t written = 0;
-    while (written < static_cast<ssize_t>(length)) {
-        ssize_t w = write(fd, data + written, length - written);
-        if (w < 0) {
-            std::cerr << "Error writing to serial port: " << strerror(errno) << "\n";
-            return false;
-        }
-        written += w;
+bool writeBytes(WinKeyerPort& port, const unsigned char* data, size_t length) {
+    if (!port.send(data, length)) {
+        std::cerr << port.error() << "\n";
+        return false;
     }
     return true;
 }
 
-bool writeCmd(int fd, unsigned char c1, unsigned char c2 = 0, bool twoBytes = false) {
+bool writeCmd(WinKeyerPort& port, unsigned char c1, unsigned char c2 = 0, bool twoBytes = false) {
     unsigned char buf[2] = { c1, c2 };
-    return writeBytes(fd, buf, twoBytes ? 2 : 1);
-}
-
-void delay_ms(unsigned int ms) {
-    usleep(ms * 1000);
+    return writeBytes(port, buf, twoBytes ? 2 : 1);
 }
 
 void updateHeader(int wpm) {
@@ -1082,31 +1382,130 @@ void updateHeader(int wpm) {
     std::cout.flush();
 }
 
-bool initWinkeyer(int fd) {
-    unsigned char hostCmd[2] = {0x00, 0x02};
-    if (!writeBytes(fd, hostCmd, 2)) return false;
-    delay_ms(300);
-    unsigned char ver;
-    int n = read(fd, &ver, 1);
-    if (n == 1)
-        std::cout << "WinKeyer firmware version: " << (int)ver << "\n";
-    else
-        std::cout << "No firmware version byte read...\n";
-    unsigned char winkMode = 0xC4;
-    if (!writeCmd(fd, 0x0E, winkMode, true)) return false;
-    delay_ms(200);
-    if (useBufferedSpeedChange) {
-        if (!writeCmd(fd, 0x1C, static_cast<unsigned char>(currentWPM), true)) return false;
-    } else {
-        if (!writeCmd(fd, 0x02, static_cast<unsigned char>(currentWPM), true)) return false;
-    }
-    delay_ms(200);
-    if (!writeCmd(fd, 0x09, pinCfg, true)) return false;
-    delay_ms(200);
-    std::cout << "WinKeyer initialized.\n";
+// Full-screen frame for the practice loops: the WPM header in the
+// top-right corner and body text from the top-left. Frames go through
+// the diffing renderer, so a keystroke repaints only what it changed.
+// `input` is when the keyer byte this frame shows arrived, if any.
+std::string screenBody;
+void drawScreen(const Keyer& keyer, const std::string& body,
+                EventLoop::Clock::time_point input = EventLoop::Clock::time_point()) {
+    screenBody = body;
+    TermRenderer& term = terminal();
+    term.clear();
+    term.print(0, 59, "WPM: " + std::to_string(keyer.settings.wpm));
+    term.print(0, 0, body);
+    term.present();
+    if (input != EventLoop::Clock::time_point())
+        MorseCore::metrics().inputToScreen.observe(EventLoop::Clock::now() - input);
+}
+
+bool sendSpeed(Keyer& keyer) {
+    std::vector<unsigned char> cmd = WinKeyerCore::speedCommand(keyer.settings);
+    return writeBytes(keyer.port, cmd.data(), cmd.size());
+}
+
+// Follows the keyer's speed pot; returns true if the speed changed.
+bool applySpeedPot(Keyer& keyer, unsigned char pot) {
+    int newWPM = WinKeyerCore::potToWpm(pot, keyer.settings.potMinWpm, keyer.settings.potMaxWpm);
+    if (newWPM == keyer.settings.wpm)
+        return false;
+    keyer.settings.wpm = newWPM;
+    sendSpeed(keyer);
     return true;
 }
 
+// Brings up every keyer in the list together. Each gets host open and,
+// the moment its version byte comes back, its whole settings batch and
+// a status request; the status reply says the batch has been taken in.
+// Only silence costs time, up to REPLY_TIMEOUT_MS per stage. A keyer
+// that cannot be written to is closed; returns false if none is left.
+bool initWinkeyers(const std::vector<Keyer*>& keyers) {
+    const int REPLY_TIMEOUT_MS = 1000;
+    auto startTime = std::chrono::steady_clock::now();
+    auto deadline = startTime;
+    auto msLeft = [&] {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        return static_cast<int>(std::max<long long>(0, left));
+    };
+    auto fail = [](Keyer& k) {
+        std::cerr << k.device << ": " << k.port.error() << "\n";
+        k.port.close();
+    };
+    for (Keyer* k : keyers) {
+        unsigned char hostCmd[2] = {0x00, 0x02};
+        if (k->port.isOpen() && !writeBytes(k->port, hostCmd, 2))
+            fail(*k);
+    }
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLY_TIMEOUT_MS);
+    for (Keyer* k : keyers) {
+        if (!k->port.isOpen())
+            continue;
+        unsigned char ver;
+        if (k->port.readRawByte(ver, msLeft()))
+            std::cout << k->device << ": WinKeyer firmware version: " << (int)ver << "\n";
+        else
+            std::cout << k->device << ": No firmware version byte read...\n";
+        std::vector<unsigned char> batch = WinKeyerCore::settingsCommands(k->settings);
+        batch.push_back(0x15);   // status request
+        if (!writeBytes(k->port, batch.data(), batch.size()))
+            fail(*k);
+    }
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLY_TIMEOUT_MS);
+    bool any = false;
+    for (Keyer* k : keyers) {
+        if (!k->port.isOpen())
+            continue;
+        if (!k->port.waitForStatus(msLeft()))
+            std::cout << k->device << ": no status reply; settings may not have been applied\n";
+        any = true;
+    }
+    if (any) {
+        std::cout << "WinKeyer initialized in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - startTime).count()
+                  << " ms.\n";
+    }
+    return any;
+}
+
+bool initWinkeyer(Keyer& keyer) {
+    return initWinkeyers({&keyer});
+}
+
+// With the keyer's own sidetone off (pin config bit 1 clear) the PC
+// plays it instead, keyed from the KEYDOWN bit of each status byte the
+// moment the byte is read. The byte has already spent 9.2 ms on the
+// wire at 1200 baud 8N2; the measured latency starts from the read.
+class PcSidetone {
+public:
+    PcSidetone(Keyer& keyer, EventLoop& loop) : keyer_(keyer) {
+        if (keyer.settings.pinCfg & 0x02)
+            return;
+        tone_ = std::make_unique<MorseModule::Sidetone>(loop, MorseModule::tonePitch);
+        MorseModule::Sidetone* tone = tone_.get();
+        keyer.port.setStatusHandler([tone](unsigned char status, WinKeyerPort::Clock::time_point when) {
+            tone->keyEdge(status & WinKeyerCore::STATUS_KEYDOWN, when);
+        });
+    }
+    ~PcSidetone() {
+        keyer_.port.setStatusHandler(nullptr);
+    }
+    PcSidetone(const PcSidetone&) = delete;
+    PcSidetone& operator=(const PcSidetone&) = delete;
+
+    // One report line, or nothing if the keyer's speaker was in use.
+    std::string report() const {
+        if (!tone_)
+            return std::string();
+        return "PC sidetone latency: " + tone_->summary() + "\n";
+    }
+
+private:
+    Keyer& keyer_;
+    std::unique_ptr<MorseModule::Sidetone> tone_;
+};
+
 struct termios orig_stdin;
 void setNonCanonicalStdin() {
     tcgetattr(STDIN_FILENO, &orig_stdin);
@@ -1120,48 +1519,83 @@ void restoreStdin() {
     tcsetattr(STDIN_FILENO, TCSANOW, &orig_stdin);
 }
 
-std::vector<std::string> winLoadWordlist(const std::string &filename) {
-    std::vector<std::string> words;
-    std::ifstream fin(filename);
-    if (!fin.is_open()) {
-        std::cerr << "Could not open '" << filename << "'\n";
-        return words;
+// Folds a session's sending analysis into the all-time per-character
+// totals kept next to the receiving stats.
+void recordSendingStats(const MorseCore::SendingReport& r, const std::string& filename) {
+    auto totals = MorseCore::loadSendingStats(filename);
+    MorseCore::mergeSendingStats(totals, r);
+    MorseCore::saveSendingStats(totals, filename);
+}
+
+// Prints the session's sending analysis and records it.
+void showSendingReport(const MorseCore::SendingAnalyzer& analyzer) {
+    MorseCore::SendingReport r = analyzer.report();
+    if (r.characters == 0)
+        return;
+    std::cout << "Sending analysis:\n";
+    if (r.charGaps.count > 0)
+        std::cout << "  Gaps between characters: median " << static_cast<int>(r.charGaps.p50Ms)
+                  << " ms, 90% under " << static_cast<int>(r.charGaps.p90Ms)
+                  << " ms, longest " << static_cast<int>(r.charGaps.maxMs) << " ms\n";
+    if (r.wordGaps.count > 0)
+        std::cout << "  Time to start a word:    median " << static_cast<int>(r.wordGaps.p50Ms)
+                  << " ms, 90% under " << static_cast<int>(r.wordGaps.p90Ms) << " ms\n";
+    if (!r.words.empty()) {
+        double sum = 0.0;
+        const MorseCore::WordSending* slowest = &r.words[0];
+        for (auto &w : r.words) {
+            sum += w.wpm;
+            if (w.wpm < slowest->wpm) slowest = &w;
+        }
+        std::cout << "  Word speed: " << static_cast<int>(sum / r.words.size() + 0.5)
+                  << " WPM average, slowest " << slowest->word << " at "
+                  << static_cast<int>(slowest->wpm + 0.5) << " WPM\n";
     }
-    std::string line;
-    while (std::getline(fin, line)) {
-        if (!line.empty())
-            words.push_back(line);
+    if (!r.perChar.empty()) {
+        std::cout << "  Character speed (WPM):";
+        for (auto &entry : r.perChar)
+            std::cout << " " << entry.first << "=" << static_cast<int>(entry.second.meanWpm + 0.5);
+        std::cout << "\n";
     }
-    return words;
+    for (auto &h : r.hotspots)
+        std::cout << "  Hesitates before " << h.c << ": " << static_cast<int>(h.meanGapMs)
+                  << " ms (" << std::fixed << std::setprecision(1) << h.ratio
+                  << std::defaultfloat << "x the median gap)\n";
+    std::cout << "\n";
+    recordSendingStats(r, "sending_stats.txt");
 }
 
-void practiceGameLoop(int fd) {
+// Practice menu shared by the practice game and the classroom; returns
+// an empty list if the user backs out or picks something invalid.
+std::vector<MorseCore::ItemId> choosePracticeItems() {
     clearScreen();
     std::cout << "===== PRACTICE MENU ======\n"
               << "1) Letters (A-Z)\n"
               << "2) Numbers (0-9)\n"
               << "3) Punctuation\n"
               << "4) Words\n"
+              << "5) Callsigns\n"
               << "0) Back\n"
               << "Enter option: ";
     std::string line;
     std::getline(std::cin, line);
-    if (line == "0") return;
-    std::vector<std::string> practiceItems;
+    if (line == "0") return {};
+    MorseCore::ItemCatalog& catalog = MorseCore::catalog();
+    std::vector<MorseCore::ItemId> practiceItems;
     if (line == "1") {
         for (char c = 'A'; c <= 'Z'; ++c)
-            practiceItems.push_back(std::string(1, c));
+            practiceItems.push_back(catalog.character(c));
     } else if (line == "2") {
         for (char c = '0'; c <= '9'; ++c)
-            practiceItems.push_back(std::string(1, c));
+            practiceItems.push_back(catalog.character(c));
     } else if (line == "3") {
-        practiceItems = {".", ",", "?", "/", "=", "-", ";"};
+        practiceItems = catalog.intern({".", ",", "?", "/", "=", "-", ";"});
     } else if (line == "4") {
-        practiceItems = winLoadWordlist("wordlist");
-        if (practiceItems.empty()) {
+        std::vector<std::string> words = MorseCore::loadWordlist("wordlist");
+        if (words.empty()) {
             std::cout << "No words found. Press Enter...\n";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            return;
+            return {};
         }
         std::cout << "Please specify the desired word length." << std::flush;
         std::getline(std::cin, line);
@@ -1174,151 +1608,144 @@ void practiceGameLoop(int fd) {
         if (letterCount <= 0) {
             std::cout << "Invalid letter count. Press Enter...\n";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            return;
-        }
-        std::vector<std::string> filteredWords;
-        for (auto &word : practiceItems) {
-            if (word.size() == static_cast<size_t>(letterCount) &&
-                std::all_of(word.begin(), word.end(), [](char c){ return std::isalpha(c); }))
-            {
-                filteredWords.push_back(word);
-            }
+            return {};
         }
+        std::vector<std::string> filteredWords = MorseCore::filterWords(words, letterCount, true);
         if (filteredWords.empty()) {
             std::cout << "No words with " << letterCount << " letters found. Press Enter...\n";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            return;
+            return {};
         }
-        practiceItems = filteredWords;
+        practiceItems = catalog.intern(filteredWords);
         
+    } else if (line == "5") {
+        practiceItems = MorseCore::buildPool(MorseCore::Category::Callsigns, MorseModule::rng());
     } else {
         std::cout << "Invalid choice. Press Enter...\n";
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        return;
+        return {};
     }
-    // REPLACE WITH:
-std::random_device rd;
-std::mt19937 rng(rd());
-std::shuffle(practiceItems.begin(), practiceItems.end(), rng);
+    return practiceItems;
+}
 
-int numItems = static_cast<int>(practiceItems.size());
-    int itemIndex = 0, numRight = 0, numWrong = 0;
-    setNonCanonicalStdin();
-    while (running && itemIndex < numItems) {
-        clearScreen();
-        updateHeader(currentWPM);
-        std::string target = practiceItems[itemIndex];
-        std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-        std::cout << "TARGET: " << target << "\n\n";
-        std::cout << "(Press ESC to quit practice)\n";
-        bool itemComplete = false;
-        std::string typed;
-        while (!itemComplete && running) {
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            FD_SET(fd, &rfds);
-            FD_SET(STDIN_FILENO, &rfds);
-            int maxfd = std::max(fd, STDIN_FILENO);
-            struct timeval tv = {0, 100000};
-            int ret = select(maxfd+1, &rfds, nullptr, nullptr, &tv);
-            if (ret > 0) {
-                if (FD_ISSET(STDIN_FILENO, &rfds)) {
-                    char c;
-                    if (read(STDIN_FILENO, &c, 1) > 0) {
-                        if (c == 27) {
-                            restoreStdin();
-                            numWrong += (numItems - itemIndex);
-                            clearScreen();
-                            std::cout << "Practice aborted.\n\n";
-                            goto showStats;
-                        }
-                    }
-                }
-                if (FD_ISSET(fd, &rfds)) {
-                    unsigned char ch;
-                    int n = read(fd, &ch, 1);
-                    if (n > 0) {
-                        if ((ch & 0xC0) == 0x80) {
-                            int potVal = ch & 0x7F;
-                            int newWPM = speedPotMinWpm + (potVal * (speedPotMaxWpm - speedPotMinWpm)) / 31;
-                            if (newWPM != currentWPM) {
-                                currentWPM = newWPM;
-                                if (useBufferedSpeedChange)
-                                    writeCmd(fd, 0x1C, static_cast<unsigned char>(currentWPM), true);
-                                else
-                                    writeCmd(fd, 0x02, static_cast<unsigned char>(currentWPM), true);
-                                clearScreen();
-                                updateHeader(currentWPM);
-                                std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                std::cout << "TARGET: " << target << "\n\n";
-                                std::cout << "You typed: " << typed << "\n\n";
-                                std::cout << "(Press ESC to quit, Space/Enter to finalize)\n";
-                            }
-                        }
-                        else if ((ch & 0xC0) == 0xC0) {
-                        }
-                        else {
-                            if (ch >= 32 && ch <= 126) {
-                                char mc = static_cast<char>(ch);
-                                if (mc == ' ' || mc == '\r' || mc == '\n') {
-                                    if (typed == target) {
-                                        numRight++;
-                                        itemComplete = true;
-                                        clearScreen();
-                                        updateHeader(currentWPM);
-                                        std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                        std::cout << "TARGET: " << target << "\n\n";
-                                        std::cout << "SUCCESS!\n\n";
-                                        delay_ms(700);
-                                    } else {
-                                        numWrong++;
-                                        itemComplete = true;
-                                        clearScreen();
-                                        updateHeader(currentWPM);
-                                        std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                        std::cout << "TARGET: " << target << "\n\n";
-                                        std::cout << "INCORRECT.\n\n";
-                                        delay_ms(700);
-                                    }
-                                }
-                                else if (mc == 8 || mc == 127) {
-                                    if (!typed.empty())
-                                        typed.pop_back();
-                                    clearScreen();
-                                    updateHeader(currentWPM);
-                                    std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                    std::cout << "TARGET: " << target << "\n\n";
-                                    std::cout << "You typed: " << typed << "\n\n";
-                                    std::cout << "(Press ESC to quit, Space/Enter to finalize)\n";
-                                }
-                                else {
-                                    typed.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(mc))));
-                                    clearScreen();
-                                    updateHeader(currentWPM);
-                                    std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                    std::cout << "TARGET: " << target << "\n\n";
-                                    std::cout << "You typed: " << typed << "\n\n";
-                                    std::cout << "(Press ESC to quit, Space/Enter to finalize)\n";
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+// What went wrong in a sent item, letter by letter, for the result line.
+std::string sendingErrors(const std::string& target, const std::string& typed) {
+    MorseCore::CopyGrade grade = MorseCore::gradeCopy(target, typed);
+    std::string out;
+    for (const MorseCore::CopyError& error : grade.errors) {
+        if (!out.empty()) out += "; ";
+        out += MorseCore::describeCopyError(grade, error);
+    }
+    return out;
+}
+
+void practiceGameLoop(Keyer& keyer) {
+    std::vector<MorseCore::ItemId> practiceItems = choosePracticeItems();
+    if (practiceItems.empty()) return;
+    MorseCore::SessionConfig config;
+    config.pool = practiceItems;
+    config.numQuestions = static_cast<int>(practiceItems.size());
+    MorseCore::Session session(config);
+    int numItems = session.numQuestions();
+    std::string target;
+    std::string typed;
+    EventLoop loop;
+    PcSidetone sidetone(keyer, loop);
+    MorseCore::SendingAnalyzer analyzer;
+    std::string sentCopy;    // the whole session, for its error rates
+    std::string typedCopy;
+
+    auto itemHeader = [&] {
+        return "Item " + std::to_string(session.questionNumber()) + " of " +
+               std::to_string(numItems) + "\nTARGET: " + target + "\n\n";
+    };
+    auto drawTyped = [&](EventLoop::Clock::time_point input) {
+        drawScreen(keyer, itemHeader() + "You typed: " + typed + "\n\n" +
+                   "(Press ESC to quit, Space/Enter to finalize)\n", input);
+    };
+    std::function<void()> nextItem;
+    WinKeyerPort::EventHandler onSerial;
+    nextItem = [&] {
+        if (session.finished()) {
+            loop.stop();
+            return;
+        }
+        target = session.nextQuestion();
+        typed.clear();
+        drawScreen(keyer, itemHeader() + "(Press ESC to quit practice)\n");
+        analyzer.beginWord(EventLoop::Clock::now());
+        keyer.port.attach(loop, onSerial);
+    };
+    onSerial = [&](const WinKeyerPort::Event& ev) {
+        unsigned char ch = ev.byte;
+        WinKeyerCore::ByteKind kind = ev.kind;
+        if (kind == WinKeyerCore::ByteKind::SpeedPot) {
+            if (applySpeedPot(keyer, ch))
+                drawTyped(ev.when);
+            return;
+        }
+        if (kind == WinKeyerCore::ByteKind::Status || ch < 32 || ch > 126) {
+            return;
         }
-        itemIndex++;
+        char mc = static_cast<char>(ch);
+        if (mc == ' ' || mc == '\r' || mc == '\n') {
+            CW_TRACE_COMPLETE("input", "keyed answer", analyzer.wordShown(), ev.when);
+            analyzer.endWord();
+            bool correct = session.submitAnswer(typed).correct;
+            sentCopy += target + " ";
+            typedCopy += typed + " ";
+            drawScreen(keyer, itemHeader() + (correct ? "SUCCESS!\n\n"
+                                                      : "INCORRECT: " + sendingErrors(target, typed) + "\n\n"),
+                       ev.when);
+            // Hold paddle input during the pause; it belongs to the next item.
+            keyer.port.hold();
+            loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(700), nextItem);
+        } else if (mc == 8 || mc == 127) {
+            if (!typed.empty())
+                typed.pop_back();
+            drawTyped(ev.when);
+        } else {
+            analyzer.addChar(mc, ev.when, keyer.settings.wpm);
+            typed.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(mc))));
+            drawTyped(ev.when);
+        }
+    };
+
+    bool aborted = false;
+    setNonCanonicalStdin();
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) > 0 && c == 27) {
+            aborted = true;
+            loop.stop();
+        }
+    });
+    nextItem();
+    while (running && !loop.stopped()) {
+        loop.runOnce();
     }
-showStats:
+    keyer.port.detach();
     restoreStdin();
+    if (aborted) {
+        clearScreen();
+        std::cout << "Practice aborted.\n\n";
+    }
     {
         int total = numItems;
+        int numRight = session.stats().correct;
+        int numWrong = total - numRight;
         clearScreen();
         std::cout << "Practice session finished!\n\n";
         std::cout << "Items asked: " << total << "\n";
         std::cout << "Right: " << numRight << "\n";
         std::cout << "Wrong: " << numWrong << "\n";
         double pct = (total > 0) ? 100.0 * static_cast<double>(numRight) / total : 0.0;
-        std::cout << "Score: " << pct << "%\n\n";
+        std::cout << "Score: " << pct << "%\n";
+        if (!sentCopy.empty())
+            MorseModule::printCopyGrade(MorseCore::gradeCopy(sentCopy, typedCopy));
+        std::cout << "\n";
+        std::cout << sidetone.report();
+        showSendingReport(analyzer);
         std::cout << "Press Enter to return to Main Menu...";
         std::cin.clear();
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -1328,7 +1755,7 @@ showStats:
     restoreStdin();
 }
 
-void speedPracticeGameLoop(int fd) {
+void speedPracticeGameLoop(Keyer& keyer) {
     clearScreen();
     std::cout << "===== SPEED PRACTICE MODE ======\n";
     std::cout << "This mode is like the Practice Game, but you set a countdown timer for each item.\n";
@@ -1348,6 +1775,7 @@ std::cout << "Select category:\n"
           << "2) Numbers (0-9)\n"
           << "3) Mix (letters + numbers)\n"
           << "4) Punctuation\n"
+          << "5) Callsigns\n"
           << "0) Return\n"
           << "Enter option: ";
 
@@ -1355,27 +1783,31 @@ std::string line;
 std::getline(std::cin, line);
 if (line == "0") return;
 
-std::vector<std::string> practiceItems;
+MorseCore::ItemCatalog& catalog = MorseCore::catalog();
+std::vector<MorseCore::ItemId> practiceItems;
 if (line == "1") {
     // Letters
     for (char c = 'A'; c <= 'Z'; ++c)
-        practiceItems.push_back(std::string(1, c));
+        practiceItems.push_back(catalog.character(c));
 
 } else if (line == "2") {
     // Numbers
     for (char c = '0'; c <= '9'; ++c)
-        practiceItems.push_back(std::string(1, c));
+        practiceItems.push_back(catalog.character(c));
 
 } else if (line == "3") {
     // Mix letters + numbers
     for (char c = 'A'; c <= 'Z'; ++c)
-        practiceItems.push_back(std::string(1, c));
+        practiceItems.push_back(catalog.character(c));
     for (char c = '0'; c <= '9'; ++c)
-        practiceItems.push_back(std::string(1, c));
+        practiceItems.push_back(catalog.character(c));
 
 } else if (line == "4") {
     // Punctuation
-    practiceItems = {".", ",", "?", "/", "=", "-", ";"};
+    practiceItems = catalog.intern({".", ",", "?", "/", "=", "-", ";"});
+
+} else if (line == "5") {
+    practiceItems = MorseCore::buildPool(MorseCore::Category::Callsigns, MorseModule::rng());
 
 } else {
     std::cout << "Invalid category. Press Enter...\n";
@@ -1394,171 +1826,167 @@ if (line == "1") {
 
 // etc.
 
-    // REPLACE WITH:
-std::random_device rd;
-std::mt19937 rng(rd());
-std::shuffle(practiceItems.begin(), practiceItems.end(), rng);
-
-int numItems = static_cast<int>(practiceItems.size());
+    MorseCore::SessionConfig config;
+    config.pool = practiceItems;
+    config.numQuestions = static_cast<int>(practiceItems.size());
+    config.timeLimitSec = timeLimitSec;
+    MorseCore::Session session(config);
+    int numItems = session.numQuestions();
     std::vector<std::pair<std::string, std::string>> missed;
-    int itemIndex = 0, numRight = 0, numWrong = 0;
-    clearScreen();
-    updateHeader(currentWPM);
-    std::cout << "Speed Practice Setup Complete.\n\n"
-              << "Time Limit per item: " << timeLimitSec << " seconds\n"
-              << "Total items: " << numItems << "\n"
-              << "Adjust WPM if needed.\n\n"
-              << "Press SPACE (or Enter) to begin...\n"
-              << "Press ESC to abort.\n";
-    setNonCanonicalStdin();
-    bool readyToStart = false;
-    while (!readyToStart && running) {
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(fd, &rfds);
-        FD_SET(STDIN_FILENO, &rfds);
-        int maxfd = std::max(fd, STDIN_FILENO);
-        struct timeval tv = {0, 10000};
-        int ret = select(maxfd+1, &rfds, nullptr, nullptr, &tv);
-        if (ret > 0) {
-            if (FD_ISSET(STDIN_FILENO, &rfds)) {
-                char c;
-                if (read(STDIN_FILENO, &c, 1) > 0) {
-                    if (c == 27) {
-                        restoreStdin();
-                        clearScreen();
-                        std::cout << "Speed practice aborted.\n";
-                        return;
-                    }
-                    else if (c == ' ' || c == '\n' || c == '\r')
-                        readyToStart = true;
-                }
+    EventLoop loop;
+    PcSidetone sidetone(keyer, loop);
+    std::string target;
+    std::string typed;
+    EventLoop::Clock::time_point itemStart;
+    EventLoop::TimerId deadlineTimer = -1;
+    MorseCore::SendingAnalyzer analyzer;
+    std::string sentCopy;    // the whole session, for its error rates
+    std::string typedCopy;
+    bool started = false;
+    bool aborted = false;
+
+    auto applyPot = [&](unsigned char ch, EventLoop::Clock::time_point when) {
+        if (applySpeedPot(keyer, ch))
+            drawScreen(keyer, screenBody, when);
+    };
+    auto itemHeader = [&] {
+        return "Item " + std::to_string(session.questionNumber()) + " of " +
+               std::to_string(numItems) + "\nTARGET: " + target + "\n\n";
+    };
+    auto drawItem = [&](EventLoop::Clock::time_point input) {
+        drawScreen(keyer, "Speed Practice\n" + itemHeader() + "You typed: " + typed + "\n" +
+                   "(Press ESC to quit, Space/Enter to finalize)\n", input);
+    };
+    auto showResult = [&](const std::string& result, EventLoop::Clock::time_point input) {
+        drawScreen(keyer, itemHeader() + result + "\n\n", input);
+    };
+    auto finalTyped = [&] {
+        std::string s = typed;
+        s.erase(s.find_last_not_of(" \n\r\t")+1);
+        return s;
+    };
+    std::function<void()> nextItem;
+    WinKeyerPort::EventHandler onSerial;
+    nextItem = [&] {
+        if (session.finished()) {
+            loop.stop();
+            return;
+        }
+        target = session.nextQuestion();
+        typed.clear();
+        itemStart = EventLoop::Clock::now();
+        analyzer.beginWord(itemStart);
+        deadlineTimer = loop.addTimer(
+            itemStart + std::chrono::duration_cast<EventLoop::Clock::duration>(
+                std::chrono::duration<double>(timeLimitSec)),
+            [&] {
+                deadlineTimer = -1;
+                CW_TRACE_COMPLETE("input", "keyed answer", itemStart, EventLoop::Clock::now());
+                analyzer.endWord();
+                std::string answer = finalTyped();
+                session.expire(answer);
+                sentCopy += target + " ";
+                typedCopy += answer + " ";
+                missed.push_back({target, answer});
+                showResult("TIME EXPIRED. INCORRECT.", EventLoop::Clock::time_point());
+                keyer.port.hold();
+                loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(700), nextItem);
+            });
+        keyer.port.attach(loop, onSerial);
+        drawItem(EventLoop::Clock::time_point());
+    };
+    onSerial = [&](const WinKeyerPort::Event& ev) {
+        unsigned char ch = ev.byte;
+        WinKeyerCore::ByteKind kind = ev.kind;
+        if (kind == WinKeyerCore::ByteKind::SpeedPot) {
+            applyPot(ch, ev.when);
+            return;
+        }
+        if (!started || kind == WinKeyerCore::ByteKind::Status || ch < 32 || ch > 126) {
+            return;
+        }
+        char mc = static_cast<char>(ch);
+        if (mc == ' ' || mc == '\r' || mc == '\n') {
+            loop.cancelTimer(deadlineTimer);
+            deadlineTimer = -1;
+            CW_TRACE_COMPLETE("input", "keyed answer", itemStart, ev.when);
+            analyzer.endWord();
+            // Bytes held over from the pause predate the item.
+            double elapsed = std::max(0.0,
+                std::chrono::duration<double>(ev.when - itemStart).count());
+            std::string answer = finalTyped();
+            sentCopy += target + " ";
+            typedCopy += answer + " ";
+            if (session.submitAnswer(answer, elapsed).correct) {
+                showResult("SUCCESS!", ev.when);
+            } else if (answer == target) {
+                showResult("INCORRECT.", ev.when);   // right, but too late
+                missed.push_back({target, answer});
+            } else {
+                showResult("INCORRECT: " + sendingErrors(target, answer), ev.when);
+                missed.push_back({target, answer});
             }
+            nextItem();
+            return;
         }
+        if (mc == 8 || mc == 127) {
+            if (!typed.empty())
+                typed.pop_back();
+        } else {
+            analyzer.addChar(mc, ev.when, keyer.settings.wpm);
+            typed.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(mc))));
+        }
+        drawItem(ev.when);
+    };
+
+    std::ostringstream setup;
+    setup << "Speed Practice Setup Complete.\n\n"
+          << "Time Limit per item: " << timeLimitSec << " seconds\n"
+          << "Total items: " << numItems << "\n"
+          << "Adjust WPM if needed.\n\n"
+          << "Press SPACE (or Enter) to begin...\n"
+          << "Press ESC to abort.\n";
+    drawScreen(keyer, setup.str());
+    setNonCanonicalStdin();
+    keyer.port.attach(loop, onSerial);
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) <= 0) return;
+        if (c == 27) {
+            aborted = true;
+            loop.stop();
+        } else if (!started && (c == ' ' || c == '\n' || c == '\r')) {
+            started = true;
+            nextItem();
+        }
+    });
+    while (running && !loop.stopped()) {
+        loop.runOnce();
     }
+    keyer.port.detach();
+    restoreStdin();
     if (!running) {
-        restoreStdin();
         return;
     }
-    while (running && itemIndex < numItems) {
+    if (aborted && !started) {
         clearScreen();
-        updateHeader(currentWPM);
-        std::string target = practiceItems[itemIndex];
-        auto startTime = std::chrono::steady_clock::now();
-        bool itemComplete = false;
-        std::string typed;
-        while (!itemComplete && running) {
-            double elapsed = std::chrono::duration<double>(
-                std::chrono::steady_clock::now() - startTime).count();
-            clearScreen();
-            updateHeader(currentWPM);
-            std::cout << "Speed Practice\n";
-            std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-            std::cout << "TARGET: " << target << "\n\n";
-            std::cout << "You typed: " << typed << "\n";
-            std::cout << "(Press ESC to quit, Space/Enter to finalize)\n";
-            fd_set rfds;
-            FD_ZERO(&rfds);
-            FD_SET(fd, &rfds);
-            FD_SET(STDIN_FILENO, &rfds);
-            int maxfd = std::max(fd, STDIN_FILENO);
-            struct timeval tv = {0, 10000};
-            int ret = select(maxfd+1, &rfds, nullptr, nullptr, &tv);
-            if (ret > 0) {
-                if (FD_ISSET(STDIN_FILENO, &rfds)) {
-                    char c;
-                    if (read(STDIN_FILENO, &c, 1) > 0) {
-                        if (c == 27) {
-                            restoreStdin();
-                            numWrong += (numItems - itemIndex);
-                            clearScreen();
-                            std::cout << "Speed practice aborted.\n\n";
-                            goto showStatsSpeed;
-                        }
-                    }
-                }
-                if (FD_ISSET(fd, &rfds)) {
-                    unsigned char ch;
-                    int n = read(fd, &ch, 1);
-                    if (n > 0) {
-                        if ((ch & 0xC0) == 0x80) {
-                            int potVal = ch & 0x7F;
-                            int newWPM = speedPotMinWpm + (potVal * (speedPotMaxWpm - speedPotMinWpm)) / 31;
-                            if (newWPM != currentWPM) {
-                                currentWPM = newWPM;
-                                if (useBufferedSpeedChange)
-                                    writeCmd(fd, 0x1C, static_cast<unsigned char>(currentWPM), true);
-                                else
-                                    writeCmd(fd, 0x02, static_cast<unsigned char>(currentWPM), true);
-                            }
-                        }
-                        else if ((ch & 0xC0) == 0xC0) {
-                        }
-                        else {
-                            if (ch >= 32 && ch <= 126) {
-                                char mc = static_cast<char>(ch);
-                                if (mc == ' ' || mc == '\r' || mc == '\n') {
-                                    std::string finalTyped = typed;
-                                    finalTyped.erase(finalTyped.find_last_not_of(" \n\r\t")+1);
-                                    if (finalTyped == target) {
-                                        numRight++;
-                                        clearScreen();
-                                        updateHeader(currentWPM);
-                                        std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                        std::cout << "TARGET: " << target << "\n\n";
-                                        std::cout << "SUCCESS!\n\n";
-                                       // delay_ms(700);
-                                    } else {
-                                        numWrong++;
-                                        clearScreen();
-                                        updateHeader(currentWPM);
-                                        std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                                        std::cout << "TARGET: " << target << "\n\n";
-                                        std::cout << "INCORRECT.\n\n";
-                                       // delay_ms(700);
-                                        missed.push_back({target, finalTyped});
-                                    }
-                                    itemComplete = true;
-                                }
-                                else if (mc == 8 || mc == 127) {
-                                    if (!typed.empty())
-                                        typed.pop_back();
-                                }
-                                else {
-                                    typed.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(mc))));
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            if (elapsed >= timeLimitSec) {
-                numWrong++;
-                std::string finalTyped = typed;
-                finalTyped.erase(finalTyped.find_last_not_of(" \n\r\t")+1);
-                missed.push_back({target, finalTyped});
-                clearScreen();
-                updateHeader(currentWPM);
-                std::cout << "Item " << (itemIndex+1) << " of " << numItems << "\n";
-                std::cout << "TARGET: " << target << "\n\n";
-                std::cout << "TIME EXPIRED. INCORRECT.\n\n";
-                delay_ms(700);
-                itemComplete = true;
-            }
-        }
-        itemIndex++;
+        std::cout << "Speed practice aborted.\n";
+        return;
     }
-showStatsSpeed:
-    restoreStdin();
     {
         int total = numItems;
+        int numRight = session.stats().correct;
+        int numWrong = total - numRight;
         clearScreen();
         std::cout << "Speed Practice session finished!\n\n";
         std::cout << "Items asked: " << total << "\n";
         std::cout << "Right: " << numRight << "\n";
         std::cout << "Wrong: " << numWrong << "\n";
         double pct = (total > 0) ? 100.0 * static_cast<double>(numRight) / total : 0.0;
-        std::cout << "Score: " << pct << "%\n\n";
+        std::cout << "Score: " << pct << "%\n";
+        if (!sentCopy.empty())
+            MorseModule::printCopyGrade(MorseCore::gradeCopy(sentCopy, typedCopy));
+        std::cout << "\n";
         if (!missed.empty()) {
             std::cout << "Missed Questions:\n";
             for (auto &p : missed) {
@@ -1571,6 +1999,8 @@ showStatsSpeed:
             }
             std::cout << "\n";
         }
+        std::cout << sidetone.report();
+        showSendingReport(analyzer);
         std::cout << "Press Enter to return to Main Menu...";
         std::cin.clear();
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -1579,7 +2009,212 @@ showStatsSpeed:
     }
 }
 
-void showPinConfigSubMenu(int fd) {
+// Upper-cases word and drops anything the keyer cannot send.
+std::string keyableText(const std::string& word) {
+    std::string out;
+    for (char c : word) {
+        char u = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (MorseCore::lookup(u))
+            out.push_back(u);
+    }
+    return out;
+}
+
+// Streams practice text into the keyer's buffer so its own sidetone and
+// rig output play it. Serial echo (mode bit 0x04) reports each character
+// as it is keyed; keeping sent - echoed under a fixed window, and pausing
+// on XOFF, holds the buffer well clear of overflow yet never empty.
+void keyerPlaybackLoop(Keyer& keyer) {
+    clearScreen();
+    std::cout << "===== KEYER PLAYBACK ======\n"
+              << "1) Words from the word list\n"
+              << "2) Five-character code groups\n"
+              << "3) Text file (e.g. a QSO transcript)\n"
+              << "0) Back\n"
+              << "Enter option: ";
+    std::string line;
+    std::getline(std::cin, line);
+    if (line == "0") return;
+
+    std::mt19937 rng(static_cast<unsigned int>(time(nullptr)));
+    std::vector<std::string> words;
+    std::ifstream textFile;
+    int count = 0;
+    std::string sourceName;
+    if (line == "1" || line == "2") {
+        if (line == "1") {
+            words = MorseCore::loadWordlist("wordlist");
+            if (words.empty()) {
+                std::cout << "No words found. Press Enter...\n";
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                return;
+            }
+        }
+        std::cout << (line == "1" ? "How many words? " : "How many groups? ");
+        std::getline(std::cin, line);
+        try { count = std::stoi(line); } catch (...) { count = 0; }
+        if (count <= 0) {
+            std::cout << "Invalid count. Press Enter...\n";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return;
+        }
+        sourceName = words.empty() ? "Code groups" : "Word list";
+    } else if (line == "3") {
+        std::cout << "Path to text file: ";
+        std::getline(std::cin, line);
+        textFile.open(line);
+        if (!textFile) {
+            std::cout << "Cannot open " << line << ". Press Enter...\n";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return;
+        }
+        sourceName = line;
+    } else {
+        std::cout << "Invalid choice. Press Enter...\n";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return;
+    }
+
+    // Produces the next word, or returns false when the source is done.
+    // Files are read a word at a time, so any length streams in constant memory.
+    int produced = 0;
+    auto nextWord = [&](std::string& out) {
+        out.clear();
+        while (out.empty()) {
+            if (textFile.is_open()) {
+                std::string w;
+                if (!(textFile >> w)) return false;
+                out = keyableText(w);
+            } else {
+                if (produced >= count) return false;
+                ++produced;
+                if (!words.empty()) {
+                    out = keyableText(words[rng() % words.size()]);
+                } else {
+                    static const char groupChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+                    for (int i = 0; i < 5; ++i)
+                        out.push_back(groupChars[rng() % (sizeof(groupChars) - 1)]);
+                }
+            }
+        }
+        return true;
+    };
+
+    const size_t WINDOW = 48;   // well under the keyer's XOFF level
+    EventLoop loop;
+    PcSidetone sidetone(keyer, loop);
+    std::string pending;
+    std::string recent;
+    size_t sent = 0;
+    size_t echoed = 0;
+    bool exhausted = false;
+    bool aborted = false;
+    bool brokenIn = false;
+    double expectedSec = 0.0;   // keying time of the echoed text at the set speed
+    EventLoop::Clock::time_point firstSend;
+    EventLoop::Clock::time_point lastEcho;
+
+    auto draw = [&] {
+        std::ostringstream body;
+        body << "Keyer Playback - " << sourceName << "\n\n"
+             << "Sent to keyer: " << sent << "   Keyed: " << echoed
+             << "   In buffer: " << (sent - echoed) << (keyer.port.xoff() ? " (XOFF)" : "") << "\n\n"
+             << recent << "\n\n"
+             << "(Press ESC to stop)\n";
+        drawScreen(keyer, body.str());
+    };
+    auto topUp = [&] {
+        while (!keyer.port.xoff() && sent - echoed < WINDOW) {
+            if (pending.empty()) {
+                std::string w;
+                if (exhausted || !nextWord(w)) {
+                    exhausted = true;
+                    break;
+                }
+                pending = w + " ";
+            }
+            size_t n = std::min(pending.size(), WINDOW - (sent - echoed));
+            if (sent == 0)
+                firstSend = EventLoop::Clock::now();
+            writeBytes(keyer.port, reinterpret_cast<const unsigned char*>(pending.data()), n);
+            pending.erase(0, n);
+            sent += n;
+        }
+        if (exhausted && echoed >= sent)
+            loop.stop();
+    };
+
+    keyer.port.attach(loop, [&](const WinKeyerPort::Event& ev) {
+        if (ev.kind == WinKeyerCore::ByteKind::SpeedPot) {
+            if (applySpeedPot(keyer, ev.byte))
+                draw();
+            return;
+        }
+        if (ev.kind == WinKeyerCore::ByteKind::Status) {
+            if (ev.byte & WinKeyerCore::STATUS_BREAKIN) {
+                // Paddle break-in clears the keyer's buffer.
+                brokenIn = true;
+                loop.stop();
+                return;
+            }
+            topUp();
+            draw();
+            return;
+        }
+        if (ev.byte < 32 || ev.byte > 126 || echoed >= sent)
+            return;
+        char c = static_cast<char>(ev.byte);
+        ++echoed;
+        lastEcho = ev.when;
+        expectedSec += MorseCore::characterUnits(c) * 1.2 / keyer.settings.wpm;
+        recent.push_back(c);
+        if (recent.size() > 60)
+            recent.erase(0, recent.size() - 60);
+        topUp();
+        draw();
+    });
+
+    setNonCanonicalStdin();
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) > 0 && c == 27) {
+            aborted = true;
+            loop.stop();
+        }
+    });
+    topUp();
+    draw();
+    while (running && !loop.stopped()) {
+        loop.runOnce();
+    }
+    keyer.port.detach();
+    restoreStdin();
+    if (aborted || brokenIn || !running)
+        writeCmd(keyer.port, 0x0A);   // clear the keyer's buffer
+
+    clearScreen();
+    if (brokenIn)
+        std::cout << "Paddle break-in; playback stopped.\n\n";
+    else if (aborted)
+        std::cout << "Playback stopped.\n\n";
+    else
+        std::cout << "Playback finished.\n\n";
+    double elapsed = std::chrono::duration<double>(lastEcho - firstSend).count();
+    std::cout << "Characters keyed: " << echoed << "\n";
+    if (echoed > 1 && elapsed > 0.0) {
+        double cps = echoed / elapsed;
+        double targetCps = echoed / expectedSec;
+        std::cout << "Achieved: " << cps << " chars/sec\n"
+                  << "Target at " << keyer.settings.wpm << " WPM: " << targetCps << " chars/sec\n"
+                  << "Keyer ran at " << (100.0 * cps / targetCps) << "% of the set speed\n";
+    }
+    std::cout << sidetone.report();
+    std::cout << "\nPress Enter to return to Main Menu...";
+    std::string dummy;
+    std::getline(std::cin, dummy);
+}
+
+void showPinConfigSubMenu(Keyer& keyer) {
     while (true) {
         clearScreen();
         std::cout << "====== PIN CONFIGURATION MENU ======\n"
@@ -1593,26 +2228,24 @@ void showPinConfigSubMenu(int fd) {
         if (line == "0")
             break;
         else if (line == "1") {
-            pinCfg = 0x0F;
-            internalSpeakerOn = true;
+            keyer.settings.pinCfg = 0x0F;
         } else if (line == "2") {
-            pinCfg = 0x0D;
-            internalSpeakerOn = false;
+            keyer.settings.pinCfg = 0x0D;
         } else if (line == "3") {
-            pinCfg = 0x07;
+            keyer.settings.pinCfg = 0x07;
         } else {
             std::cout << "\nInvalid choice.\nPress Enter to continue...";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             continue;
         }
-        writeCmd(fd, 0x09, pinCfg, true);
-        std::cout << "\nPin config set to 0x" << std::hex << (int)pinCfg << std::dec << ".\n";
+        writeCmd(keyer.port, 0x09, keyer.settings.pinCfg, true);
+        std::cout << "\nPin config set to 0x" << std::hex << (int)keyer.settings.pinCfg << std::dec << ".\n";
         std::cout << "Press Enter to continue...";
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
 }
 
-void showSettingsMenu(int fd) {
+void showSettingsMenu(Keyer& keyer) {
     while(true) {
         clearScreen();
         std::cout << "========== SETTINGS MENU ==========\n";
@@ -1638,12 +2271,9 @@ void showSettingsMenu(int fd) {
             if (spd < 5 || spd > 99)
                 std::cout << "Invalid speed.\n";
             else {
-                if (useBufferedSpeedChange)
-                    writeCmd(fd, 0x1C, static_cast<unsigned char>(spd), true);
-                else
-                    writeCmd(fd, 0x02, static_cast<unsigned char>(spd), true);
-                currentWPM = spd;
-                updateHeader(currentWPM);
+                keyer.settings.wpm = spd;
+                sendSpeed(keyer);
+                updateHeader(keyer.settings.wpm);
                 std::cout << "Speed set to " << spd << " WPM.\n";
             }
             std::cout << "Press Enter to continue...\n";
@@ -1658,7 +2288,8 @@ void showSettingsMenu(int fd) {
             if (w < 10 || w > 90)
                 std::cout << "Invalid weighting.\n";
             else {
-                writeCmd(fd, 0x03, static_cast<unsigned char>(w), true);
+                writeCmd(keyer.port, 0x03, static_cast<unsigned char>(w), true);
+                keyer.settings.weighting = w;
                 std::cout << "Weighting set to " << w << "%.\n";
             }
             std::cout << "Press Enter...\n";
@@ -1673,7 +2304,8 @@ void showSettingsMenu(int fd) {
             if (f < 10 || f > 99)
                 std::cout << "Invalid Farnsworth.\n";
             else {
-                writeCmd(fd, 0x0D, static_cast<unsigned char>(f), true);
+                writeCmd(keyer.port, 0x0D, static_cast<unsigned char>(f), true);
+                keyer.settings.farnsworthWpm = f;
                 std::cout << "Farnsworth speed: " << f << " WPM.\n";
             }
             std::cout << "Press Enter...\n";
@@ -1688,7 +2320,8 @@ void showSettingsMenu(int fd) {
             if (ratio < 33 || ratio > 66)
                 std::cout << "Invalid ratio.\n";
             else {
-                writeCmd(fd, 0x17, static_cast<unsigned char>(ratio), true);
+                writeCmd(keyer.port, 0x17, static_cast<unsigned char>(ratio), true);
+                keyer.settings.ditDahRatio = ratio;
                 std::cout << "Dit/Dah ratio: " << ratio << ".\n";
             }
             std::cout << "Press Enter...\n";
@@ -1703,7 +2336,8 @@ void showSettingsMenu(int fd) {
             if (comp < 0 || comp > 250)
                 std::cout << "Invalid.\n";
             else {
-                writeCmd(fd, 0x11, static_cast<unsigned char>(comp), true);
+                writeCmd(keyer.port, 0x11, static_cast<unsigned char>(comp), true);
+                keyer.settings.keyCompMs = comp;
                 std::cout << "Key Compensation: " << comp << " ms.\n";
             }
             std::cout << "Press Enter...\n";
@@ -1717,7 +2351,7 @@ void showSettingsMenu(int fd) {
     }
 }
 
-void showHardwareOptionsMenu(int fd) {
+void showHardwareOptionsMenu(Keyer& keyer) {
     while (true) {
         clearScreen();
         std::cout << "====== HARDWARE OPTIONS MENU ======\n";
@@ -1725,7 +2359,8 @@ void showHardwareOptionsMenu(int fd) {
         std::cout << "2) Set PTT Tail Delay (ms)\n";
         std::cout << "3) Set Pin Configuration\n";
         std::cout << "4) Set Speed Pot Range\n";
-        std::cout << "5) Toggle Internal Speaker (" << (internalSpeakerOn ? "ON" : "OFF") << ")\n";
+        std::cout << "5) Toggle Internal Speaker ("
+                  << (WinKeyerCore::internalSpeakerOn(keyer.settings) ? "ON" : "OFF, PC sidetone") << ")\n";
         std::cout << "0) Return\n";
         std::cout << "Enter option: ";
         std::string line;
@@ -1743,14 +2378,10 @@ void showHardwareOptionsMenu(int fd) {
             if (lead < 0 || lead > 250)
                 std::cout << "Invalid.\n";
             else {
-                int leadByte = lead / 10;
-                unsigned char cmd[5];
-                cmd[0] = 0x04;
-                cmd[1] = static_cast<unsigned char>(leadByte);
-                cmd[2] = 0;
-                cmd[3] = 0;
-                cmd[4] = 0;
-                writeBytes(fd, cmd, 5);
+                keyer.settings.pttLeadMs = lead;
+                unsigned char cmd[3] = {0x04, static_cast<unsigned char>(lead / 10),
+                                        static_cast<unsigned char>(keyer.settings.pttTailMs / 10)};
+                writeBytes(keyer.port, cmd, 3);
                 std::cout << "PTT Lead-In: " << lead << " ms.\n";
             }
             std::cout << "Press Enter...\n";
@@ -1765,14 +2396,10 @@ void showHardwareOptionsMenu(int fd) {
             if (tail < 0 || tail > 250)
                 std::cout << "Invalid.\n";
             else {
-                int tailByte = tail / 10;
-                unsigned char cmd[5];
-                cmd[0] = 0x04;
-                cmd[1] = 0;
-                cmd[2] = static_cast<unsigned char>(tailByte);
-                cmd[3] = 0;
-                cmd[4] = 0;
-                writeBytes(fd, cmd, 5);
+                keyer.settings.pttTailMs = tail;
+                unsigned char cmd[3] = {0x04, static_cast<unsigned char>(keyer.settings.pttLeadMs / 10),
+                                        static_cast<unsigned char>(tail / 10)};
+                writeBytes(keyer.port, cmd, 3);
                 std::cout << "PTT Tail Delay: " << tail << " ms.\n";
             }
             std::cout << "Press Enter...\n";
@@ -1780,7 +2407,7 @@ void showHardwareOptionsMenu(int fd) {
             break;
         }
         case 3: {
-            showPinConfigSubMenu(fd);
+            showPinConfigSubMenu(keyer);
             break;
         }
         case 4: {
@@ -1798,9 +2425,9 @@ void showHardwareOptionsMenu(int fd) {
             else {
                 int range = maxW - minW;
                 unsigned char cmd[4] = {0x05, static_cast<unsigned char>(minW), static_cast<unsigned char>(range), 0};
-                writeBytes(fd, cmd, 4);
-                speedPotMinWpm = minW;
-                speedPotMaxWpm = maxW;
+                writeBytes(keyer.port, cmd, 4);
+                keyer.settings.potMinWpm = minW;
+                keyer.settings.potMaxWpm = maxW;
                 std::cout << "Speed Pot Range: " << minW << " - " << maxW << "\n";
             }
             std::cout << "Press Enter...\n";
@@ -1808,10 +2435,10 @@ void showHardwareOptionsMenu(int fd) {
             break;
         }
         case 5: {
-            internalSpeakerOn = !internalSpeakerOn;
-            pinCfg = (internalSpeakerOn ? 0x0F : 0x0D);
-            writeCmd(fd, 0x09, pinCfg, true);
-            std::cout << "Speaker => " << (internalSpeakerOn ? "ON" : "OFF") << "\n";
+            bool speakerOn = !WinKeyerCore::internalSpeakerOn(keyer.settings);
+            keyer.settings.pinCfg = (speakerOn ? 0x0F : 0x0D);
+            writeCmd(keyer.port, 0x09, keyer.settings.pinCfg, true);
+            std::cout << "Speaker => " << (speakerOn ? "ON" : "OFF") << "\n";
             std::cout << "Press Enter...\n";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             break;
@@ -1823,13 +2450,13 @@ void showHardwareOptionsMenu(int fd) {
     }
 }
 
-void showOtherOptionsMenu(int fd) {
+void showOtherOptionsMenu(Keyer& keyer) {
     while (true) {
         clearScreen();
         std::cout << "======= OTHER OPTIONS MENU =======\n";
         std::cout << "1) Set WinKeyer Mode\n";
         std::cout << "2) Toggle Speed Command Mode (currently " 
-                  << (useBufferedSpeedChange ? "buffered (0x1C)" : "direct (0x02)") << ")\n";
+                  << (keyer.settings.bufferedSpeed ? "buffered (0x1C)" : "direct (0x02)") << ")\n";
         std::cout << "0) Return\n";
         std::cout << "Enter option: ";
         std::string line;
@@ -1863,16 +2490,17 @@ void showOtherOptionsMenu(int fd) {
                         std::cout << "Invalid.\n";
                         continue;
                 }
-                writeCmd(fd, 0x0E, modeVal, true);
+                writeCmd(keyer.port, 0x0E, modeVal, true);
+                keyer.settings.mode = modeVal;
                 std::cout << "Mode set.\nPress Enter...\n";
                 std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             }
             break;
         }
         case 2: {
-            useBufferedSpeedChange = !useBufferedSpeedChange;
+            keyer.settings.bufferedSpeed = !keyer.settings.bufferedSpeed;
             std::cout << "Now using " 
-                      << (useBufferedSpeedChange ? "buffered (0x1C)" : "direct (0x02)") 
+                      << (keyer.settings.bufferedSpeed ? "buffered (0x1C)" : "direct (0x02)") 
                       << " speed.\n";
             std::cout << "Press Enter...\n";
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -1885,6 +2513,67 @@ void showOtherOptionsMenu(int fd) {
     }
 }
 
+void showProfilesMenu(Keyer& keyer) {
+    while (true) {
+        std::map<std::string, WinKeyerCore::KeyerSettings> profiles =
+            WinKeyerCore::loadKeyerProfiles(PROFILES_FILE);
+        clearScreen();
+        std::cout << "====== SETTINGS PROFILES ======\n"
+                  << "Saved:";
+        if (profiles.empty())
+            std::cout << " (none)";
+        for (auto& entry : profiles)
+            std::cout << " " << entry.first;
+        std::cout << "\nApplied at connect: " << startupProfile << "\n\n"
+                  << "1) Save current settings as a profile\n"
+                  << "2) Apply a saved profile\n"
+                  << "3) Delete a profile\n"
+                  << "0) Return\n"
+                  << "Enter option: ";
+        std::string line;
+        std::getline(std::cin, line);
+        if (line == "0")
+            break;
+        if (line != "1" && line != "2" && line != "3") {
+            std::cout << "Invalid.\n";
+            continue;
+        }
+        std::cout << "Profile name (Enter for " << startupProfile << "): ";
+        std::string name;
+        std::getline(std::cin, name);
+        if (name.empty())
+            name = startupProfile;
+        if (line == "1") {
+            profiles[name] = keyer.settings;
+            if (WinKeyerCore::saveKeyerProfiles(profiles, PROFILES_FILE))
+                std::cout << "Saved profile " << name << ".\n";
+            else
+                std::cout << "Could not write " << PROFILES_FILE << ".\n";
+        } else if (profiles.find(name) == profiles.end()) {
+            std::cout << "No profile named " << name << ".\n";
+        } else if (line == "2") {
+            keyer.settings = profiles[name];
+            std::vector<unsigned char> batch = WinKeyerCore::settingsCommands(keyer.settings);
+            writeBytes(keyer.port, batch.data(), batch.size());
+            std::cout << "Applied profile " << name << ".\n";
+        } else {
+            profiles.erase(name);
+            WinKeyerCore::saveKeyerProfiles(profiles, PROFILES_FILE);
+            std::cout << "Deleted profile " << name << ".\n";
+        }
+        std::cout << "Press Enter...\n";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+}
+
+// Starts a keyer from the startup profile, if one has been saved.
+void loadStartupProfile(Keyer& keyer) {
+    auto profiles = WinKeyerCore::loadKeyerProfiles(PROFILES_FILE);
+    auto it = profiles.find(startupProfile);
+    if (it != profiles.end())
+        keyer.settings = it->second;
+}
+
 std::string getMainMenuOption() {
     clearScreen();
     std::cout << "========== Winkeyer Menu ==========\n"
@@ -1893,6 +2582,8 @@ std::string getMainMenuOption() {
               << "3) Other Options\n"
               << "4) Practice Game\n"
               << "5) Speed Practice\n"
+              << "6) Keyer Playback\n"
+              << "7) Settings Profiles\n"
               << "0) Back\n"
               << "Enter option: ";
     std::string opt;
@@ -1902,50 +2593,33 @@ std::string getMainMenuOption() {
 
 void winkeyerMain() {
     signal(SIGINT, sigint_handler);
-    std::string device = "/dev/ttyUSB0";
-    int fd = open(device.c_str(), O_RDWR | O_NOCTTY | O_SYNC);
-    if (fd < 0) {
-        std::cerr << "Error opening " << device << ": " << strerror(errno) << "\n";
-        return;
-    }
-    struct termios tty;
-    memset(&tty, 0, sizeof(tty));
-    if (tcgetattr(fd, &tty) != 0) {
-        std::cerr << "tcgetattr error: " << strerror(errno) << "\n";
-        close(fd);
-        return;
-    }
-    cfmakeraw(&tty);
-    cfsetispeed(&tty, B1200);
-    cfsetospeed(&tty, B1200);
-    tty.c_cflag |= CSTOPB;
-    tty.c_cflag &= ~CRTSCTS;
-    tty.c_cflag |= CLOCAL | CREAD;
-    tty.c_cflag &= ~CSIZE;
-    tty.c_cflag |= CS8;
-    tty.c_cflag &= ~PARENB;
-    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
-        std::cerr << "tcsetattr() error: " << strerror(errno) << "\n";
-        close(fd);
+    Keyer keyer;
+    keyer.device = devicePaths.front();
+    loadStartupProfile(keyer);
+    if (!keyer.port.open(keyer.device)) {
+        std::cerr << keyer.port.error() << "\n";
         return;
     }
-    if (!initWinkeyer(fd)) {
-        close(fd);
+    if (!initWinkeyer(keyer)) {
         return;
     }
     bool exitProgram = false;
     while (!exitProgram && running) {
         std::string choice = getMainMenuOption();
         if (choice == "1")
-            showSettingsMenu(fd);
+            showSettingsMenu(keyer);
         else if (choice == "2")
-            showHardwareOptionsMenu(fd);
+            showHardwareOptionsMenu(keyer);
         else if (choice == "3")
-            showOtherOptionsMenu(fd);
+            showOtherOptionsMenu(keyer);
         else if (choice == "4")
-            practiceGameLoop(fd);
+            practiceGameLoop(keyer);
         else if (choice == "5")
-            speedPracticeGameLoop(fd);
+            speedPracticeGameLoop(keyer);
+        else if (choice == "6")
+            keyerPlaybackLoop(keyer);
+        else if (choice == "7")
+            showProfilesMenu(keyer);
         else if (choice == "0")
             exitProgram = true;
         else {
@@ -1953,24 +2627,545 @@ void winkeyerMain() {
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         }
     }
-    close(fd);
+    writeCmd(keyer.port, 0x00, 0x03, true);   // host close
+    keyer.port.close();
     std::cout << "\nExiting WinKeyer module...\n";
     std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
+// ------------------------------------------------------------
+// Classroom: one keyer per student, all served by one event loop.
+// Each station has its own keyer settings, session and sending
+// analysis, so a speed pot or paddle on one desk never reaches
+// another.
+// ------------------------------------------------------------
+struct Station {
+    Keyer keyer;
+    std::string student;
+    std::unique_ptr<MorseCore::Session> session;
+    MorseCore::SendingAnalyzer analyzer;
+    std::string target;
+    std::string typed;
+    std::string result;
+    bool done = false;
+};
+
+// Parses a list like "1,3-5" into 0-based indices below count; an empty
+// line means all of them, and anything unreadable gives an empty list.
+std::vector<size_t> parseStationList(const std::string& line, size_t count) {
+    std::vector<size_t> picked;
+    if (line.find_first_not_of(" \t") == std::string::npos) {
+        for (size_t i = 0; i < count; ++i)
+            picked.push_back(i);
+        return picked;
+    }
+    std::stringstream ss(line);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        std::istringstream ps(part);
+        int first = 0;
+        if (!(ps >> first))
+            return {};
+        int last = first;
+        char dash;
+        if (ps >> dash && (dash != '-' || !(ps >> last)))
+            return {};
+        for (int i = first; i <= last; ++i) {
+            if (i < 1 || static_cast<size_t>(i) > count)
+                return {};
+            if (std::find(picked.begin(), picked.end(), static_cast<size_t>(i - 1)) == picked.end())
+                picked.push_back(static_cast<size_t>(i - 1));
+        }
+    }
+    return picked;
+}
+
+std::string scoreboardText(const std::vector<std::unique_ptr<Station>>& stations) {
+    std::ostringstream out;
+    out << "===== CLASSROOM SENDING =====   (Press ESC to end)\n\n" << std::left
+        << std::setw(4) << "#" << std::setw(13) << "Student" << std::setw(8) << "Item"
+        << std::setw(12) << "Target" << std::setw(12) << "Sent" << std::setw(7) << "Right"
+        << std::setw(7) << "Wrong" << std::setw(5) << "WPM" << "Status\n";
+    for (size_t i = 0; i < stations.size(); ++i) {
+        const Station& st = *stations[i];
+        const MorseCore::SessionStats& stats = st.session->stats();
+        std::string item = std::to_string(st.session->questionNumber()) + "/" +
+                           std::to_string(st.session->numQuestions());
+        std::string status = st.keyer.port.hungUp() ? "OFFLINE" : st.done ? "Finished" : st.result;
+        out << std::setw(4) << i + 1 << std::setw(13) << st.student.substr(0, 12)
+            << std::setw(8) << item << std::setw(12) << st.target.substr(0, 11)
+            << std::setw(12) << st.typed.substr(0, 11) << std::setw(7) << stats.correct
+            << std::setw(7) << stats.asked - stats.correct << std::setw(5) << st.keyer.settings.wpm
+            << status << "\n";
+    }
+    return out.str();
+}
+
+void classroomLoop(std::vector<std::unique_ptr<Station>>& stations) {
+    EventLoop loop;
+    EventLoop::TimerId redrawTimer = -1;
+    EventLoop::Clock::time_point oldestInput;   // earliest keyer byte not yet on screen
+    auto redraw = [&] {
+        TermRenderer& term = terminal();
+        term.clear();
+        term.print(0, 0, scoreboardText(stations));
+        term.present();
+        if (oldestInput != EventLoop::Clock::time_point()) {
+            MorseCore::metrics().inputToScreen.observe(EventLoop::Clock::now() - oldestInput);
+            oldestInput = EventLoop::Clock::time_point();
+        }
+    };
+    // A room full of keyers echoes at once; repaint at most ~30 times a second.
+    auto requestRedraw = [&](EventLoop::Clock::time_point input = EventLoop::Clock::time_point()) {
+        if (oldestInput == EventLoop::Clock::time_point())
+            oldestInput = input;
+        if (redrawTimer >= 0)
+            return;
+        redrawTimer = loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(33), [&] {
+            redrawTimer = -1;
+            redraw();
+        });
+    };
+    auto allDone = [&] {
+        for (auto& st : stations)
+            if (!st->done && !st->keyer.port.hungUp())
+                return false;
+        return true;
+    };
+
+    std::vector<std::function<void()>> nextItem(stations.size());
+    std::vector<WinKeyerPort::EventHandler> onSerial(stations.size());
+    for (size_t i = 0; i < stations.size(); ++i) {
+        nextItem[i] = [&, i] {
+            Station& st = *stations[i];
+            st.typed.clear();
+            if (st.session->finished()) {
+                st.done = true;
+                st.target.clear();
+                if (allDone())
+                    loop.stop();
+                requestRedraw();
+                return;
+            }
+            st.target = st.session->nextQuestion();
+            st.result.clear();
+            st.analyzer.beginWord(EventLoop::Clock::now());
+            st.keyer.port.attach(loop, onSerial[i]);
+            requestRedraw();
+        };
+        onSerial[i] = [&, i](const WinKeyerPort::Event& ev) {
+            Station& st = *stations[i];
+            if (ev.kind == WinKeyerCore::ByteKind::SpeedPot) {
+                if (applySpeedPot(st.keyer, ev.byte))
+                    requestRedraw(ev.when);
+                return;
+            }
+            if (ev.kind == WinKeyerCore::ByteKind::Status || ev.byte < 32 || ev.byte > 126) {
+                return;
+            }
+            char mc = static_cast<char>(ev.byte);
+            if (mc == ' ') {
+                CW_TRACE_COMPLETE("input", "keyed answer", st.analyzer.wordShown(), ev.when);
+                st.analyzer.endWord();
+                st.result = st.session->submitAnswer(st.typed).correct ? "SUCCESS" : "INCORRECT";
+                // Hold this desk's paddle input during the pause, as in the practice game.
+                st.keyer.port.hold();
+                loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(700), nextItem[i]);
+            } else {
+                st.analyzer.addChar(mc, ev.when, st.keyer.settings.wpm);
+                st.typed.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(mc))));
+            }
+            requestRedraw(ev.when);
+        };
+    }
+
+    // A keyer that hangs up sends no event to say so; check now and then.
+    std::function<void()> housekeeping = [&] {
+        if (allDone())
+            loop.stop();
+        requestRedraw();
+        loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(500), housekeeping);
+    };
+
+    setNonCanonicalStdin();
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) > 0 && c == 27)
+            loop.stop();
+    });
+    terminal().clearScreen();
+    for (auto& f : nextItem)
+        f();
+    housekeeping();
+    while (running && !loop.stopped()) {
+        loop.runOnce();
+    }
+    for (auto& st : stations)
+        st->keyer.port.detach();
+    restoreStdin();
+}
+
+void showClassroomResults(const std::vector<std::unique_ptr<Station>>& stations) {
+    std::vector<const Station*> ranked;
+    for (auto& st : stations)
+        ranked.push_back(st.get());
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Station* a, const Station* b) {
+        const MorseCore::SessionStats& sa = a->session->stats();
+        const MorseCore::SessionStats& sb = b->session->stats();
+        if (sa.correct != sb.correct)
+            return sa.correct > sb.correct;
+        return sa.accuracy() > sb.accuracy();
+    });
+    clearScreen();
+    std::cout << "Classroom session finished!\n\n";
+    int place = 0;
+    for (const Station* st : ranked) {
+        const MorseCore::SessionStats& stats = st->session->stats();
+        MorseCore::SendingReport r = st->analyzer.report(1);
+        std::string score = std::to_string(stats.correct) + " of " + std::to_string(stats.asked) +
+                            " (" + std::to_string(static_cast<int>(stats.accuracy() + 0.5)) + "%)";
+        std::string detail;
+        if (r.charGaps.count > 0)
+            detail += "  gap median " + std::to_string(static_cast<int>(r.charGaps.p50Ms)) + " ms";
+        if (!r.hotspots.empty())
+            detail += std::string("  hesitates before ") + r.hotspots[0].c;
+        std::cout << std::left << std::setw(4) << ++place << std::setw(13) << st->student.substr(0, 12)
+                  << std::setw(detail.empty() ? 0 : 16) << score << std::right << detail << "\n";
+        if (r.characters == 0)
+            continue;
+        std::string file = "sending_stats_";
+        for (char c : st->student)
+            file.push_back(std::isalnum(static_cast<unsigned char>(c)) || c == '-' ? c : '_');
+        recordSendingStats(r, file + ".txt");
+    }
+    std::cout << "\nPress Enter to return to Main Menu...";
+    std::string dummy;
+    std::getline(std::cin, dummy);
+}
+
+void classroomMain() {
+    signal(SIGINT, sigint_handler);
+    clearScreen();
+    std::vector<std::string> devices = findKeyerDevices();
+    for (const std::string& d : devicePaths) {
+        if (std::find(devices.begin(), devices.end(), d) == devices.end() && access(d.c_str(), F_OK) == 0)
+            devices.push_back(d);
+    }
+    if (devices.empty()) {
+        std::cout << "No keyers found (looked for /dev/ttyUSB* and /dev/ttyACM*;\n"
+                  << "name others with --device). Press Enter...\n";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return;
+    }
+    std::cout << "===== CLASSROOM SENDING =====\n";
+    for (size_t i = 0; i < devices.size(); ++i)
+        std::cout << i + 1 << ") " << devices[i] << "\n";
+    std::cout << "Keyers to use (e.g. 1,3-5; Enter for all): ";
+    std::string line;
+    std::getline(std::cin, line);
+    std::vector<size_t> picked = parseStationList(line, devices.size());
+    if (picked.empty()) {
+        std::cout << "Invalid selection. Press Enter...\n";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return;
+    }
+
+    std::vector<std::unique_ptr<Station>> stations;
+    std::vector<Keyer*> keyers;
+    for (size_t idx : picked) {
+        std::unique_ptr<Station> st = std::make_unique<Station>();
+        st->keyer.device = devices[idx];
+        loadStartupProfile(st->keyer);
+        if (!st->keyer.port.open(st->keyer.device)) {
+            std::cerr << st->keyer.port.error() << "\n";
+            continue;
+        }
+        keyers.push_back(&st->keyer);
+        stations.push_back(std::move(st));
+    }
+    if (keyers.empty() || !initWinkeyers(keyers)) {
+        std::cout << "No keyer could be opened. Press Enter...\n";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return;
+    }
+    stations.erase(std::remove_if(stations.begin(), stations.end(),
+                                  [](const std::unique_ptr<Station>& st) { return !st->keyer.port.isOpen(); }),
+                   stations.end());
+
+    std::random_device seeds;
+    std::vector<MorseCore::ItemId> items;
+    for (size_t i = 0; i < stations.size(); ++i) {
+        Station& st = *stations[i];
+        std::cout << "\nStudent at " << st.keyer.device << ": ";
+        std::getline(std::cin, st.student);
+        if (st.student.empty())
+            st.student = "Station " + std::to_string(i + 1);
+        if (!items.empty()) {
+            std::cout << "Same practice list as the previous station? (Y/n) ";
+            std::getline(std::cin, line);
+        }
+        if (items.empty() || line == "n" || line == "N") {
+            items = choosePracticeItems();
+            if (items.empty())
+                return;
+        }
+        MorseCore::SessionConfig config;
+        config.pool = items;
+        config.numQuestions = static_cast<int>(items.size());
+        config.seed = seeds();   // every desk gets its own order
+        st.session = std::make_unique<MorseCore::Session>(config);
+    }
+    std::cout << "\n" << stations.size() << " keyers ready. Press Enter to start...";
+    std::getline(std::cin, line);
+
+    classroomLoop(stations);
+    for (auto& st : stations) {
+        if (st->keyer.port.isOpen() && !st->keyer.port.hungUp())
+            writeCmd(st->keyer.port, 0x00, 0x03, true);   // host close
+    }
+    if (running)
+        showClassroomResults(stations);
+}
+
 } // end namespace WinKeyerModule
 
+namespace StraightKeyModule {
+
+std::string keyDevicePath = "/dev/ttyUSB0";
+
+void clearScreen() {
+    terminal().clearScreen();
+}
+
+// Decodes a live or replayed key with sidetone until ESC or the end of
+// the recording. Each edge goes to the sidetone first, then the decoder.
+void runKeySession(SerialKeyInput* live, const std::vector<MorseCore::KeyEdge>* replay,
+                   float pitch, const std::string& recordPath) {
+    EventLoop loop;
+    ReplayKeyInput player;
+    MorseCore::KeyDecoder decoder;
+    std::vector<MorseCore::KeyEdge> recorded;
+    std::string text;
+    EventLoop::TimerId flushTimer = -1;
+    std::function<void()> draw;
+    MorseModule::Sidetone sidetone(loop, pitch, [&] { draw(); });
+
+    draw = [&] {
+        std::string shown = text.size() > 60 ? text.substr(text.size() - 60) : text;
+        std::ostringstream body;
+        body << "Straight Key Practice" << (replay ? " (replay)" : "") << "\n\n"
+             << "Decoded: " << shown << "\n\n"
+             << "Estimated speed: " << decoder.wpm() << " WPM\n"
+             << "Edge-to-sidetone latency: " << sidetone.summary() << "\n\n"
+             << "(Press ESC to stop)\n";
+        TermRenderer& term = terminal();
+        term.clear();
+        term.print(0, 0, body.str());
+        term.present();
+    };
+    std::function<void()> armFlush = [&] {
+        if (flushTimer >= 0)
+            loop.cancelTimer(flushTimer);
+        flushTimer = -1;
+        EventLoop::Clock::time_point due = decoder.nextDeadline();
+        if (due == EventLoop::Clock::time_point::max())
+            return;
+        flushTimer = loop.addTimer(due, [&] {
+            flushTimer = -1;
+            text += decoder.flush(EventLoop::Clock::now());
+            armFlush();
+            draw();
+        });
+    };
+    auto onEdge = [&](const MorseCore::KeyEdge& edge) {
+        sidetone.keyEdge(edge.down, edge.when);
+        recorded.push_back(edge);
+        text += decoder.addEdge(edge);
+        armFlush();
+        draw();
+    };
+    // A replay ends once its last edge is in and decoded.
+    std::function<void()> checkFinished = [&] {
+        if (player.finished() && decoder.nextDeadline() == EventLoop::Clock::time_point::max()) {
+            loop.stop();
+            return;
+        }
+        loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(50), checkFinished);
+    };
+
+    if (live) {
+        if (!live->start(loop, onEdge, [&] { loop.stop(); })) {
+            std::cout << live->error() << "\nPress Enter...";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            return;
+        }
+    } else {
+        player.start(loop, *replay, onEdge);
+    }
+    MorseModule::RawInput raw;
+    loop.watch(STDIN_FILENO, [&](uint32_t) {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) > 0 && c == 27)
+            loop.stop();
+    });
+    draw();
+    if (replay)
+        checkFinished();
+    loop.run();
+    if (live)
+        live->stop();
+    player.stop();
+
+    clearScreen();
+    if (live && live->failed())
+        std::cout << live->error() << "\n\n";
+    std::cout << "Decoded text:\n" << text << "\n\n"
+              << "Final speed estimate: " << decoder.wpm() << " WPM\n"
+              << "Edge-to-sidetone latency: " << sidetone.summary() << "\n";
+    if (!recordPath.empty() && !recorded.empty()) {
+        if (MorseCore::saveKeyEdges(recorded, recordPath))
+            std::cout << "Saved " << recorded.size() << " edges to " << recordPath << "\n";
+        else
+            std::cout << "Could not write " << recordPath << "\n";
+    }
+    std::cout << "\nPress Enter to continue...";
+    std::string dummy;
+    std::getline(std::cin, dummy);
+}
+
+void straightKeyMain() {
+    while (true) {
+        clearScreen();
+        std::cout << "===== STRAIGHT KEY / BUG ======\n"
+                  << "1) Live key on a serial port (" << keyDevicePath << ")\n"
+                  << "2) Replay a recorded key file\n"
+                  << "0) Back\n"
+                  << "Enter option: ";
+        std::string line;
+        std::getline(std::cin, line);
+        if (line == "0")
+            return;
+        if (line != "1" && line != "2") {
+            std::cout << "Invalid option. Press Enter...\n";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            continue;
+        }
+        std::cout << "Sidetone pitch (Hz, Enter for " << MorseModule::tonePitch << "): ";
+        std::string pitchLine;
+        std::getline(std::cin, pitchLine);
+        float pitch = MorseModule::tonePitch;
+        try { pitch = std::stof(pitchLine); } catch (...) { pitch = MorseModule::tonePitch; }
+
+        if (line == "1") {
+            std::cout << "Key lines: 1) CTS  2) DSR  3) either [3]: ";
+            std::string lines;
+            std::getline(std::cin, lines);
+            int mask = (lines == "1") ? TIOCM_CTS : (lines == "2") ? TIOCM_DSR : (TIOCM_CTS | TIOCM_DSR);
+            std::cout << "Record edges to file (blank for none): ";
+            std::string recordPath;
+            std::getline(std::cin, recordPath);
+            SerialKeyInput input;
+            if (!input.open(keyDevicePath, mask)) {
+                std::cout << input.error() << "\nPress Enter...";
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                continue;
+            }
+            runKeySession(&input, nullptr, pitch, recordPath);
+        } else {
+            std::cout << "Recorded key file: ";
+            std::string path;
+            std::getline(std::cin, path);
+            std::vector<MorseCore::KeyEdge> edges =
+                MorseCore::loadKeyEdges(path, std::chrono::steady_clock::time_point());
+            if (edges.empty()) {
+                std::cout << "No edges in " << path << ". Press Enter...\n";
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                continue;
+            }
+            runKeySession(nullptr, &edges, pitch, "");
+        }
+    }
+}
+
+} // end namespace StraightKeyModule
+
 // ------------------------------------------------------------
 // Top-Level Main Menu
 // ------------------------------------------------------------
-int main() {
+int main(int argc, char** argv) {
+    if (const char* env = std::getenv("CW_WINKEYER_DEVICE")) {
+        WinKeyerModule::devicePaths = {env};
+    }
+    if (const char* env = std::getenv("CW_KEY_DEVICE")) {
+        StraightKeyModule::keyDevicePath = env;
+    }
+    std::string audioSpec;
+    if (const char* env = std::getenv("CW_AUDIO")) {
+        audioSpec = env;
+    }
+    std::string metricsTarget;
+    if (const char* env = std::getenv("CW_METRICS")) {
+        metricsTarget = env;
+    }
+    double metricsInterval = 5.0;
+    std::vector<std::string> devices;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--device" && i + 1 < argc) {
+            devices.push_back(argv[++i]);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            WinKeyerModule::startupProfile = argv[++i];
+        } else if (arg == "--key-device" && i + 1 < argc) {
+            StraightKeyModule::keyDevicePath = argv[++i];
+        } else if (arg == "--audio" && i + 1 < argc) {
+            audioSpec = argv[++i];
+        } else if (arg == "--period" && i + 1 < argc) {
+            MorseModule::audioOptions.periodFrames = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metricsTarget = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            metricsInterval = std::strtod(argv[++i], nullptr);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--device PATH]... [--profile NAME] [--key-device PATH]\n"
+                      << "       [--audio OUTPUT[:DEVICE_OR_FILE]] [--period FRAMES]\n"
+                      << "       [--metrics FILE|unix:SOCKET] [--metrics-interval SECONDS]\n";
+            return 2;
+        }
+    }
+    // "alsa:hw:0,0" or "wav:session.wav"; the part after the first colon
+    // is the device or file.
+    size_t colon = audioSpec.find(':');
+    MorseModule::audioOptions.backend = audioSpec.substr(0, colon);
+    if (colon != std::string::npos) {
+        MorseModule::audioOptions.target = audioSpec.substr(colon + 1);
+    }
+    std::string audioError;
+    if (!makeAudioBackend(MorseModule::audioOptions, audioError)) {
+        std::cerr << audioError << "\n";
+        return 2;
+    }
+    if (!devices.empty()) {
+        WinKeyerModule::devicePaths = devices;
+    }
+#ifdef CW_ENABLE_TRACING
+    const char* tracePath = std::getenv("CW_TRACE");
+    MorseCore::traceStart(tracePath ? tracePath : "cw_trace.json");
+    CW_TRACE_THREAD("main");
+#endif
+    MetricsExporter metricsExporter;
+    if (!metricsTarget.empty() && !metricsExporter.start(metricsTarget, metricsInterval)) {
+        std::cerr << metricsExporter.error() << "\n";
+        return 2;
+    }
     while (true) {
         globalClearScreen();
         std::cout << "=====Morse Code========\n"
                   << "1: Patrice Receiving\n"
                   << "2: Patrice Sending\n"
-                  << "3: Exit Program\n"
-                  << "Enter your choise (1-3) ";
+                  << "3: Straight Key / Bug\n"
+                  << "4: Classroom Sending\n"
+                  << "5: Exit Program\n"
+                  << "Enter your choise (1-5) ";
         int choice;
         std::cin >> choice;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -1979,6 +3174,10 @@ int main() {
         } else if (choice == 2) {
             WinKeyerModule::winkeyerMain();
         } else if (choice == 3) {
+            StraightKeyModule::straightKeyMain();
+        } else if (choice == 4) {
+            WinKeyerModule::classroomMain();
+        } else if (choice == 5) {
             break;
         } else {
             std::cout << "Invalid option. Press Enter to try again.";
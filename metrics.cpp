@@ -0,0 +1,120 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+namespace MorseCore {
+
+namespace {
+
+std::string number(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+void header(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void sample(std::string& out, const std::string& name, double value) {
+    out += name;
+    out += ' ';
+    out += number(value);
+    out += '\n';
+}
+
+void histogram(std::string& out, const char* name, const char* help, const Histogram& h) {
+    header(out, name, "histogram", help);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= Histogram::BUCKETS; ++i) {
+        cumulative += h.bucket(i);
+        std::string le = i < Histogram::BUCKETS ? number(Histogram::BOUNDS[i]) : "+Inf";
+        sample(out, std::string(name) + "_bucket{le=\"" + le + "\"}", static_cast<double>(cumulative));
+    }
+    sample(out, std::string(name) + "_sum", h.sum());
+    sample(out, std::string(name) + "_count", static_cast<double>(cumulative));
+}
+
+} // namespace
+
+const double Histogram::BOUNDS[BUCKETS] = {
+    0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0
+};
+
+void Histogram::observe(double seconds) {
+    if (!(seconds > 0.0)) seconds = 0.0;
+    size_t i = 0;
+    while (i < BUCKETS && seconds > BOUNDS[i]) ++i;
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    sumNanos_.fetch_add(static_cast<uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+Metrics& metrics() {
+    static Metrics m;
+    return m;
+}
+
+MetricsSample sampleMetrics(const Metrics& m) {
+    MetricsSample s;
+    s.when = std::chrono::steady_clock::now();
+    s.winkeyerBytesIn = m.winkeyerBytesIn.value();
+    s.winkeyerBytesOut = m.winkeyerBytesOut.value();
+    s.winkeyerCommands = m.winkeyerCommands.value();
+    s.questions = m.questions.value();
+    return s;
+}
+
+std::string formatMetrics(const Metrics& m, MetricsSample* previous) {
+    MetricsSample now = sampleMetrics(m);
+    std::string out;
+    out.reserve(4096);
+
+    header(out, "cw_audio_underruns_total", "counter", "Times the audio output ran dry and played a gap.");
+    sample(out, "cw_audio_underruns_total", static_cast<double>(m.audioUnderruns.value()));
+    header(out, "cw_audio_periods_total", "counter", "Periods of audio handed to the output.");
+    sample(out, "cw_audio_periods_total", static_cast<double>(m.audioPeriods.value()));
+
+    histogram(out, "cw_render_seconds", "Time to render one message's audio.", m.renderSeconds);
+    histogram(out, "cw_answer_to_tone_seconds",
+              "Time from an answer to the first tone of the next question.", m.answerToTone);
+    histogram(out, "cw_input_to_screen_seconds",
+              "Time from a keyer byte arriving to the screen frame showing it.", m.inputToScreen);
+
+    header(out, "cw_winkeyer_bytes_total", "counter", "Bytes moved over WinKeyer serial ports.");
+    sample(out, "cw_winkeyer_bytes_total{direction=\"in\"}", static_cast<double>(now.winkeyerBytesIn));
+    sample(out, "cw_winkeyer_bytes_total{direction=\"out\"}", static_cast<double>(now.winkeyerBytesOut));
+    header(out, "cw_winkeyer_commands_total", "counter", "Host writes to WinKeyers: a command or a run of text.");
+    sample(out, "cw_winkeyer_commands_total", static_cast<double>(now.winkeyerCommands));
+    header(out, "cw_questions_total", "counter", "Questions asked, all sessions.");
+    sample(out, "cw_questions_total", static_cast<double>(now.questions));
+    header(out, "cw_active_sessions", "gauge", "Training sessions in progress.");
+    sample(out, "cw_active_sessions", static_cast<double>(m.activeSessions.value()));
+
+    if (previous) {
+        double sec = std::chrono::duration<double>(now.when - previous->when).count();
+        auto rate = [sec](uint64_t later, uint64_t earlier) {
+            return sec > 0.0 ? (later - earlier) / sec : 0.0;
+        };
+        header(out, "cw_winkeyer_bytes_per_second", "gauge", "WinKeyer bytes per second since the last report.");
+        sample(out, "cw_winkeyer_bytes_per_second{direction=\"in\"}",
+               rate(now.winkeyerBytesIn, previous->winkeyerBytesIn));
+        sample(out, "cw_winkeyer_bytes_per_second{direction=\"out\"}",
+               rate(now.winkeyerBytesOut, previous->winkeyerBytesOut));
+        header(out, "cw_winkeyer_commands_per_second", "gauge", "WinKeyer commands per second since the last report.");
+        sample(out, "cw_winkeyer_commands_per_second", rate(now.winkeyerCommands, previous->winkeyerCommands));
+        header(out, "cw_questions_per_minute", "gauge", "Questions asked per minute since the last report.");
+        sample(out, "cw_questions_per_minute", 60.0 * rate(now.questions, previous->questions));
+        *previous = now;
+    }
+    return out;
+}
+
+} // end namespace MorseCore
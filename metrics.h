@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ------------------------------------------------------------
+// Runtime health metrics. Each one is a few relaxed atomics bumped
+// where the event happens: no lock, no allocation, no formatting.
+// Text is only produced when an exporter asks for it, in Prometheus
+// exposition format, so a trainer nobody scrapes pays an
+// uncontended increment or two per event and nothing else.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "metrics need lock-free 64-bit atomics");
+
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// Durations against one fixed ladder of buckets, from half a
+// millisecond (a screen update) to seconds (a slow answer).
+class Histogram {
+public:
+    static constexpr size_t BUCKETS = 13;
+    static const double BOUNDS[BUCKETS];   // upper bounds, seconds
+
+    void observe(double seconds);
+    void observe(std::chrono::steady_clock::duration d) {
+        observe(std::chrono::duration<double>(d).count());
+    }
+
+    // Observations in bucket i alone (not cumulative); i == BUCKETS
+    // is everything above the last bound.
+    uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+    double sum() const { return sumNanos_.load(std::memory_order_relaxed) * 1e-9; }
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS + 1] = {};
+    std::atomic<uint64_t> sumNanos_{0};
+};
+
+// Holds a gauge one higher for its own lifetime, copies included;
+// a member of whatever the gauge counts.
+class GaugeHold {
+public:
+    explicit GaugeHold(Gauge& gauge) : gauge_(&gauge) { gauge_->add(1); }
+    GaugeHold(const GaugeHold& other) : gauge_(other.gauge_) { gauge_->add(1); }
+    GaugeHold& operator=(const GaugeHold&) { return *this; }
+    ~GaugeHold() { gauge_->add(-1); }
+
+private:
+    Gauge* gauge_;
+};
+
+struct Metrics {
+    Counter audioUnderruns;       // the output ran dry and played a gap
+    Counter audioPeriods;         // periods handed to the output
+    Histogram renderSeconds;      // rendering one message's audio
+    Histogram answerToTone;       // answer recorded to the next question's first tone
+    Histogram inputToScreen;      // keyer byte to the frame that shows it
+    Counter winkeyerBytesIn;
+    Counter winkeyerBytesOut;
+    Counter winkeyerCommands;     // host writes: a command or a run of text
+    Counter questions;            // questions asked, all sessions
+    Gauge activeSessions;
+};
+
+// The process's metrics.
+Metrics& metrics();
+
+// Counter values at one instant; two of them make the rate gauges.
+struct MetricsSample {
+    std::chrono::steady_clock::time_point when;
+    uint64_t winkeyerBytesIn = 0;
+    uint64_t winkeyerBytesOut = 0;
+    uint64_t winkeyerCommands = 0;
+    uint64_t questions = 0;
+};
+
+MetricsSample sampleMetrics(const Metrics& m);
+
+// Everything in Prometheus text format (version 0.0.4). Given the
+// sample from the previous call, it also reports WinKeyer bytes and
+// commands per second and questions per minute over the time since,
+// and moves the sample on to now.
+std::string formatMetrics(const Metrics& m, MetricsSample* previous = nullptr);
+
+} // end namespace MorseCore
@@ -0,0 +1,162 @@
+#include "metrics_exporter.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char* const SOCKET_PREFIX = "unix:";
+
+// How long a client gets to send its request, and to take the reply,
+// before the exporter moves on.
+const int REQUEST_WAIT_MS = 100;
+const int REPLY_TIMEOUT_SEC = 1;
+
+bool writeAll(int fd, const std::string& text) {
+    size_t done = 0;
+    while (done < text.size()) {
+        ssize_t n = send(fd, text.data() + done, text.size() - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const std::string& target, double intervalSec) {
+    stop();
+    socket_ = target.compare(0, std::strlen(SOCKET_PREFIX), SOCKET_PREFIX) == 0;
+    path_ = socket_ ? target.substr(std::strlen(SOCKET_PREFIX)) : target;
+    intervalMs_ = std::max(1, static_cast<int>(std::lround(intervalSec * 1000.0)));
+    if (path_.empty()) {
+        error_ = "No metrics file or socket given";
+        return false;
+    }
+    previous_ = MorseCore::sampleMetrics(MorseCore::metrics());
+
+    if (socket_) {
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof(addr.sun_path)) {
+            error_ = "Socket path too long: " + path_;
+            return false;
+        }
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        // A socket left by an earlier run would make bind() fail; any
+        // other kind of file is left alone.
+        struct stat st;
+        if (lstat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(path_.c_str());
+        }
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd_, 8) != 0) {
+            error_ = "Cannot listen on " + path_ + ": " + strerror(errno);
+            if (listenFd_ >= 0) close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+    } else if (!writeFile()) {
+        error_ = "Cannot write " + path_ + ": " + strerror(errno);
+        return false;
+    }
+
+    if (pipe2(wakeFds_, O_CLOEXEC) != 0) {
+        error_ = std::string("pipe: ") + strerror(errno);
+        stop();
+        return false;
+    }
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (thread_.joinable()) {
+        char b = 0;
+        while (write(wakeFds_[1], &b, 1) < 0 && errno == EINTR) {}
+        thread_.join();
+    }
+    for (int& fd : wakeFds_) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(path_.c_str());
+    }
+}
+
+void MetricsExporter::run() {
+    struct pollfd fds[2] = {{wakeFds_[0], POLLIN, 0}, {listenFd_, POLLIN, 0}};
+    for (;;) {
+        int n = poll(fds, socket_ ? 2 : 1, socket_ ? -1 : intervalMs_);
+        if (n < 0 && errno != EINTR) break;
+        if (fds[0].revents) {
+            // Leave the last values behind for whoever reads the file.
+            if (!socket_) writeFile();
+            break;
+        }
+        if (!socket_ && n == 0) {
+            writeFile();
+        } else if (socket_ && (fds[1].revents & POLLIN)) {
+            serveClient();
+        }
+    }
+}
+
+bool MetricsExporter::writeFile() {
+    std::string text = MorseCore::formatMetrics(MorseCore::metrics(), &previous_);
+    std::string tmp = path_ + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    ok = std::fclose(f) == 0 && ok;
+    return ok && std::rename(tmp.c_str(), path_.c_str()) == 0;
+}
+
+void MetricsExporter::serveClient() {
+    int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    struct timeval timeout = {REPLY_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // An HTTP client (curl --unix-socket, a scraping proxy) speaks
+    // first; a bare reader (socat, nc -U) may not speak at all.
+    char request[1024];
+    ssize_t got = 0;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, REQUEST_WAIT_MS) > 0) {
+        got = read(fd, request, sizeof(request));
+    }
+    bool http = got >= 4 && std::memcmp(request, "GET ", 4) == 0;
+
+    std::string body = MorseCore::formatMetrics(MorseCore::metrics(), &previous_);
+    std::string reply;
+    if (http) {
+        reply = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    }
+    reply += body;
+    writeAll(fd, reply);
+    close(fd);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <thread>
+
+#include "metrics.h"
+
+// ------------------------------------------------------------
+// Publishes MorseCore::metrics() for Prometheus, on a thread of its
+// own. A file target is rewritten every interval through a rename,
+// so a reader never sees half of it (the node_exporter textfile
+// collector reads such files). "unix:PATH" listens on a Unix socket
+// instead and formats only when a client connects, so an idle
+// trainer does no work at all; a client that sends an HTTP request
+// gets an HTTP response, anything else just the text.
+// ------------------------------------------------------------
+class MetricsExporter {
+public:
+    MetricsExporter() = default;
+    ~MetricsExporter();
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // On failure returns false and error() says why.
+    bool start(const std::string& target, double intervalSec);
+    void stop();
+    bool running() const { return thread_.joinable(); }
+    const std::string& error() const { return error_; }
+
+private:
+    void run();
+    bool writeFile();
+    void serveClient();
+
+    std::string path_;
+    bool socket_ = false;
+    int intervalMs_ = 5000;
+    int listenFd_ = -1;
+    int wakeFds_[2] = {-1, -1};   // a byte on the pipe stops the thread
+    std::thread thread_;
+    MorseCore::MetricsSample previous_;
+    std::string error_;
+};
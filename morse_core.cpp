@@ -0,0 +1,345 @@
+#include "morse_core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+// Pattern of up to 6 elements -> table slot: a leading 1 bit marks the
+// length, then one bit per element (dash = 1). Returns -1 if too long.
+int patternIndex(const char* pattern) {
+    int index = 1;
+    for (const char* p = pattern; *p; ++p) {
+        if (index >= 64) return -1;
+        index = (index << 1) | (*p == '-' ? 1 : 0);
+    }
+    return index;
+}
+
+// Indexed by ASCII code; lower case is folded to upper case in lookup().
+// decoded[] is the reverse map, indexed by patternIndex().
+struct Table {
+    const char* codes[128] = {};
+    char decoded[128] = {};
+    Table() {
+        const std::pair<char, const char*> entries[] = {
+            {'A', ".-"},    {'B', "-..."},  {'C', "-.-."},  {'D', "-.."},
+            {'E', "."},     {'F', "..-."},  {'G', "--."},   {'H', "...."},
+            {'I', ".."},    {'J', ".---"},  {'K', "-.-"},   {'L', ".-.."},
+            {'M', "--"},    {'N', "-."},    {'O', "---"},   {'P', ".--."},
+            {'Q', "--.-"},  {'R', ".-."},   {'S', "..."},   {'T', "-"},
+            {'U', "..-"},   {'V', "...-"},  {'W', ".--"},   {'X', "-..-"},
+            {'Y', "-.--"},  {'Z', "--.."},
+            {'0', "-----"}, {'1', ".----"}, {'2', "..---"}, {'3', "...--"},
+            {'4', "....-"}, {'5', "....."}, {'6', "-...."}, {'7', "--..."},
+            {'8', "---.."}, {'9', "----."},
+            {'.', ".-.-.-"}, {',', "--..--"}, {'?', "..--.."}, {'!', "-.-.--"},
+            {'-', "-....-"}, {'/', "-..-."},  {'(', "-.--."},  {')', "-.--.-"},
+            {':', "---..."}, {';', "-.-.-."}, {'=', "-...-"},  {'+', ".-.-."},
+            {'\"', ".-..-."}, {'\'', ".----."}, {'&', ".-..."}, {'_', "..--.-"},
+            {'@', ".--.-."}
+        };
+        for (auto &e : entries) {
+            codes[static_cast<unsigned char>(e.first)] = e.second;
+            decoded[patternIndex(e.second)] = e.first;
+        }
+    }
+};
+
+const Table table;
+
+int msToSamples(float ms, int sampleRate) {
+    return static_cast<int>(std::lround(ms * sampleRate / 1000.0f));
+}
+
+// Below this, starting threads costs more than it saves (a couple of
+// minutes of audio renders in milliseconds anyway).
+const size_t PARALLEL_RENDER_MIN_CHARS = 2000;
+
+} // namespace
+
+const char* lookup(char c) {
+    unsigned char uc = static_cast<unsigned char>(std::toupper(static_cast<unsigned char>(c)));
+    return uc < 128 ? table.codes[uc] : nullptr;
+}
+
+char decode(const std::string& pattern) {
+    int index = patternIndex(pattern.c_str());
+    return index < 0 ? 0 : table.decoded[index];
+}
+
+const std::map<std::string, std::string>& prosigns() {
+    static const std::map<std::string, std::string> table = {
+        {"AR", "AR"},
+        {"AS", "AS"},
+        {"BK", "BK"},
+        {"BT", "BT"},
+        {"KA", "KA"},
+        {"KN", "KN"},
+        {"CL", "CL"},
+        {"CQ", "CQ"},
+        {"K",  "K"},
+        {"R",  "R"},
+        {"SK", "SK"},
+        {"VE", "VE"}
+    };
+    return table;
+}
+
+std::string sendingText(const std::string& item) {
+    auto it = prosigns().find(item);
+    return it != prosigns().end() ? it->second : item;
+}
+
+const std::vector<std::vector<char>>& letterGroups() {
+    static const std::vector<std::vector<char>> groups = {
+        {'E','I','S','H'},
+        {'T','M','O'},
+        {'A','U','V','N','D','B'},
+        {'F','L','G','W','Q','Y'},
+        {'K','R','P','X'},
+        {'C','J','Z'}
+    };
+    return groups;
+}
+
+Timing makeTiming(int wpm, int effectiveWpm, int sampleRate) {
+    float unitDuration       = 1200.0f / wpm;
+    float farnsworthDuration = 1200.0f / effectiveWpm;
+    Timing t;
+    t.sampleRate       = sampleRate;
+    t.ditSamples       = msToSamples(unitDuration, sampleRate);
+    t.dahSamples       = msToSamples(3 * unitDuration, sampleRate);
+    t.intraCharSamples = msToSamples(unitDuration, sampleRate);
+    t.interCharSamples = msToSamples(3 * farnsworthDuration, sampleRate);
+    t.interWordSamples = msToSamples(7 * farnsworthDuration, sampleRate);
+    return t;
+}
+
+int characterUnits(char c) {
+    if (c == ' ') {
+        return 4;   // on top of the 3-unit gap after the previous character
+    }
+    const char* pattern = lookup(c);
+    if (!pattern) {
+        return 0;
+    }
+    int units = 0;
+    for (const char* p = pattern; *p; ++p) {
+        units += (*p == '-') ? 4 : 2;
+    }
+    return units + 2;
+}
+
+void synthesizeTone(short* out, int numSamples, float frequency, int sampleRate,
+                    int firstSample) {
+    for (int i = 0; i < numSamples; ++i) {
+        out[i] = static_cast<short>(
+            32767 * sin(2.0 * 3.14159 * frequency * (firstSample + i) / sampleRate)
+        );
+    }
+}
+
+size_t messageLength(const std::string& text, const Timing& timing) {
+    size_t total = 0;
+    for (char c : text) {
+        const char* pattern = lookup(c);
+        if (pattern) {
+            for (const char* p = pattern; *p; ++p) {
+                total += (*p == '.' ? timing.ditSamples : timing.dahSamples);
+                total += timing.intraCharSamples;
+            }
+            total += timing.interCharSamples;
+        } else if (c == ' ') {
+            total += timing.interWordSamples;
+        }
+    }
+    return total;
+}
+
+size_t lastToneEnd(const std::string& text, const Timing& timing) {
+    size_t total = 0;
+    size_t end = 0;
+    for (char c : text) {
+        const char* pattern = lookup(c);
+        if (pattern) {
+            for (const char* p = pattern; *p; ++p) {
+                total += (*p == '.' ? timing.ditSamples : timing.dahSamples);
+                end = total;
+                total += timing.intraCharSamples;
+            }
+            total += timing.interCharSamples;
+        } else if (c == ' ') {
+            total += timing.interWordSamples;
+        }
+    }
+    return end;
+}
+
+size_t renderMessage(const std::string& text, float pitch, const Timing& timing,
+                     std::vector<short>& out) {
+    CW_TRACE_SPAN("synth", "renderMessage");
+    out.resize(messageLength(text, timing));
+    MessageRenderer renderer(text, pitch, timing);
+    renderer.render(out.data(), out.size());
+    return lastToneEnd(text, timing);
+}
+
+size_t renderMessageParallel(const std::string& text, float pitch, const Timing& timing,
+                             std::vector<short>& out, unsigned threads) {
+    CW_TRACE_SPAN("synth", "renderMessageParallel");
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1 || text.size() < PARALLEL_RENDER_MIN_CHARS) {
+        return renderMessage(text, pitch, timing, out);
+    }
+
+    // Several pieces per thread, taken in turn, so a thread that drew
+    // the short characters does not sit idle.
+    struct Piece {
+        size_t begin, end;   // characters
+        size_t offset;       // first sample
+    };
+    std::vector<Piece> pieces;
+    size_t target = text.size() / (threads * 4) + 1;
+    size_t samples = 0;
+    for (size_t begin = 0; begin < text.size();) {
+        size_t end = text.find(' ', std::min(begin + target, text.size()));
+        end = (end == std::string::npos) ? text.size() : end + 1;
+        pieces.push_back({begin, end, samples});
+        samples += messageLength(text.substr(begin, end - begin), timing);
+        begin = end;
+    }
+    out.resize(samples);
+
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t i; (i = next++) < pieces.size();) {
+            const Piece& piece = pieces[i];
+            size_t length = (i + 1 < pieces.size() ? pieces[i + 1].offset : samples) - piece.offset;
+            CW_TRACE_SPAN("synth", "render piece");
+            MessageRenderer renderer(text.substr(piece.begin, piece.end - piece.begin), pitch, timing);
+            renderer.render(out.data() + piece.offset, length);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(threads, pieces.size()); ++t) {
+        pool.emplace_back([&] {
+            CW_TRACE_THREAD("render");
+            work();
+        });
+    }
+    work();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+
+    for (size_t i = pieces.size(); i-- > 0;) {
+        size_t end = lastToneEnd(text.substr(pieces[i].begin, pieces[i].end - pieces[i].begin), timing);
+        if (end > 0) {
+            return pieces[i].offset + end;
+        }
+    }
+    return 0;
+}
+
+MessageRenderer::MessageRenderer(const std::string& text, float pitch, const Timing& timing)
+    : text_(text), pitch_(pitch), timing_(timing) {
+    segments_.reserve(16);
+}
+
+bool MessageRenderer::loadNextChar() {
+    segments_.clear();
+    segIndex_ = 0;
+    segOffset_ = 0;
+    while (charIndex_ < text_.size()) {
+        char c = text_[charIndex_++];
+        const char* pattern = lookup(c);
+        if (pattern) {
+            for (const char* p = pattern; *p; ++p) {
+                segments_.push_back({true, *p == '.' ? timing_.ditSamples : timing_.dahSamples});
+                segments_.push_back({false, timing_.intraCharSamples});
+            }
+            segments_.push_back({false, timing_.interCharSamples});
+            return true;
+        } else if (c == ' ') {
+            segments_.push_back({false, timing_.interWordSamples});
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MessageRenderer::render(short* out, size_t capacity) {
+    size_t written = 0;
+    while (written < capacity) {
+        if (segIndex_ >= segments_.size() && !loadNextChar()) {
+            break;
+        }
+        const Segment& seg = segments_[segIndex_];
+        size_t n = std::min(capacity - written, static_cast<size_t>(seg.length - segOffset_));
+        if (seg.tone) {
+            synthesizeTone(out + written, static_cast<int>(n), pitch_, timing_.sampleRate, segOffset_);
+        } else {
+            std::memset(out + written, 0, n * sizeof(short));
+        }
+        written += n;
+        segOffset_ += static_cast<int>(n);
+        if (segOffset_ >= seg.length) {
+            ++segIndex_;
+            segOffset_ = 0;
+        }
+    }
+    position_ += written;
+    return written;
+}
+
+bool MessageRenderer::done() const {
+    if (segIndex_ < segments_.size()) return false;
+    for (size_t i = charIndex_; i < text_.size(); ++i) {
+        if (text_[i] == ' ' || lookup(text_[i])) return false;
+    }
+    return true;
+}
+
+std::vector<std::string> loadWordlist(const std::string& filename) {
+    CW_TRACE_SPAN("persist", "loadWordlist");
+    std::vector<std::string> words;
+    std::ifstream fin(filename);
+    if (!fin) {
+        return words;
+    }
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (!line.empty())
+            words.push_back(line);
+    }
+    return words;
+}
+
+std::vector<std::string> filterWords(const std::vector<std::string>& words,
+                                     int letterCount, bool alphaOnly) {
+    std::vector<std::string> filtered;
+    for (const auto &word : words) {
+        if (static_cast<int>(word.size()) != letterCount)
+            continue;
+        if (alphaOnly &&
+            !std::all_of(word.begin(), word.end(),
+                         [](char c){ return std::isalpha(static_cast<unsigned char>(c)); }))
+            continue;
+        filtered.push_back(word);
+    }
+    return filtered;
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Morse core: the table, timing and tone synthesis shared by the
+// terminal modes and the benchmarks (questions: item_catalog.h).
+// Nothing in here touches std::cin/std::cout or the sound card.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+static const int SAMPLE_RATE = 44100;
+
+// Dot/dash pattern for a character (case-insensitive), or nullptr
+// when the character has no Morse mapping.
+const char* lookup(char c);
+
+// Character for a dot/dash pattern, or 0 when there is none.
+char decode(const std::string& pattern);
+
+// Prosign name -> text that is keyed for it.
+const std::map<std::string, std::string>& prosigns();
+
+// Text to key for a question item (prosigns map to their sending form).
+std::string sendingText(const std::string& item);
+
+enum class Category {
+    Letters,
+    Numbers,
+    Mixed,        // letters + numbers
+    Prosigns,
+    Punctuation,
+    Callsigns     // freshly generated, see callsign.h
+};
+
+// Number of calls in a Callsigns pool.
+static const size_t CALLSIGN_POOL_SIZE = 200;
+
+// Letter groups taught in order by the lessons mode.
+const std::vector<std::vector<char>>& letterGroups();
+
+// Sample counts for every element of a message. All lengths are whole
+// samples so a message always renders to the same buffer.
+struct Timing {
+    int sampleRate;
+    int ditSamples;
+    int dahSamples;
+    int intraCharSamples;  // after every dot or dash
+    int interCharSamples;  // after every character
+    int interWordSamples;  // for every space
+};
+
+Timing makeTiming(int wpm, int effectiveWpm, int sampleRate = SAMPLE_RATE);
+
+// Keying time of one character in dit units at standard spacing,
+// including the gap after it; a space adds the rest of a word gap.
+// Characters without a mapping take no time.
+int characterUnits(char c);
+
+// Fills out[0..numSamples) with a full-scale sine tone; firstSample is
+// the offset into the tone, so a tone can be produced in pieces.
+void synthesizeTone(short* out, int numSamples, float frequency, int sampleRate,
+                    int firstSample = 0);
+
+// Number of samples renderMessage() produces for text.
+size_t messageLength(const std::string& text, const Timing& timing);
+
+// Index one past the last sample of the final tone in text.
+size_t lastToneEnd(const std::string& text, const Timing& timing);
+
+// Renders text to 16-bit mono samples. Returns the index one past the
+// last sample of the final tone (trailing silence excluded).
+size_t renderMessage(const std::string& text, float pitch, const Timing& timing,
+                     std::vector<short>& out);
+
+// renderMessage() for long texts: the text is cut at spaces and the
+// pieces are rendered on `threads` threads (0 = one per core), each
+// straight into its place in out. A character renders to the same
+// samples wherever it falls, so out is identical to renderMessage()'s.
+size_t renderMessageParallel(const std::string& text, float pitch, const Timing& timing,
+                             std::vector<short>& out, unsigned threads = 0);
+
+// Incremental renderer: produces a message a buffer at a time into
+// memory owned by the caller. Never blocks.
+class MessageRenderer {
+public:
+    MessageRenderer() = default;
+    MessageRenderer(const std::string& text, float pitch, const Timing& timing);
+
+    // Writes up to capacity samples; returns how many were written.
+    // Returns 0 once the whole message has been produced.
+    size_t render(short* out, size_t capacity);
+    bool done() const;
+    size_t position() const { return position_; }
+
+private:
+    struct Segment {
+        bool tone;
+        int length;
+    };
+    bool loadNextChar();
+
+    std::string text_;
+    float pitch_ = 0.0f;
+    Timing timing_ = {};
+    size_t charIndex_ = 0;
+    std::vector<Segment> segments_;
+    size_t segIndex_ = 0;
+    int segOffset_ = 0;
+    size_t position_ = 0;
+};
+
+std::vector<std::string> loadWordlist(const std::string& filename);
+
+// Words of exactly letterCount characters; alphaOnly also drops
+// entries such as "160M" that contain digits or punctuation.
+std::vector<std::string> filterWords(const std::vector<std::string>& words,
+                                     int letterCount, bool alphaOnly);
+
+} // end namespace MorseCore
@@ -0,0 +1,53 @@
+#include "playback_clock.h"
+
+#include <algorithm>
+
+namespace MorseCore {
+
+namespace {
+
+int64_t toNs(PlaybackClock::Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+PlaybackClock::PlaybackClock(int sampleRate, Clock::duration window)
+    : sampleRate_(sampleRate),
+      windowNs_(std::chrono::duration_cast<std::chrono::nanoseconds>(window).count()) {}
+
+void PlaybackClock::observe(uint64_t frame, Clock::time_point when) {
+    int64_t nowNs = toNs(when);
+    int64_t frameNs = static_cast<int64_t>(frame * 1000000000ull / sampleRate_);
+    int64_t base = nowNs - frameNs;
+
+    if (!haveCurrent_ || nowNs - windowStartNs_ > windowNs_) {
+        if (haveCurrent_) {
+            previousMin_ = currentMin_;
+            havePrevious_ = true;
+        }
+        currentMin_ = base;
+        windowStartNs_ = nowNs;
+        haveCurrent_ = true;
+    } else {
+        currentMin_ = std::min(currentMin_, base);
+    }
+}
+
+int64_t PlaybackClock::baseNs() const {
+    if (haveCurrent_ && havePrevious_) return std::min(currentMin_, previousMin_);
+    return haveCurrent_ ? currentMin_ : previousMin_;
+}
+
+PlaybackClock::Clock::time_point PlaybackClock::timeOf(uint64_t frame) const {
+    int64_t ns = baseNs() + static_cast<int64_t>(frame * 1000000000ull / sampleRate_);
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+uint64_t PlaybackClock::frameAt(Clock::time_point when) const {
+    int64_t ns = toNs(when) - baseNs();
+    if (ns <= 0) return 0;
+    return static_cast<uint64_t>(ns) * sampleRate_ / 1000000000ull;
+}
+
+} // end namespace MorseCore
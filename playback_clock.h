@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace MorseCore {
+
+// ------------------------------------------------------------
+// Maps audio frame numbers onto the monotonic clock.
+//
+// The audio device reports how many frames it has played, but only
+// in coarse steps (one mixer period at a time), so a single reading
+// can lag the real position by several milliseconds. Every reading
+// gives an upper bound on when frame 0 was played; keeping the
+// smallest bound over a sliding window converges on the true
+// position within a fraction of a millisecond, and the window lets
+// the estimate follow slow drift between the sound card and the
+// system clock.
+// ------------------------------------------------------------
+class PlaybackClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PlaybackClock(int sampleRate, Clock::duration window = std::chrono::seconds(2));
+
+    // Record that the device reported `frame` as played at `when`.
+    void observe(uint64_t frame, Clock::time_point when);
+
+    bool valid() const { return haveCurrent_ || havePrevious_; }
+
+    // Best estimate of when `frame` leaves (or left) the device.
+    Clock::time_point timeOf(uint64_t frame) const;
+
+    // Best estimate of the frame playing at `when`.
+    uint64_t frameAt(Clock::time_point when) const;
+
+    int sampleRate() const { return sampleRate_; }
+
+private:
+    int64_t baseNs() const;
+
+    int sampleRate_;
+    int64_t windowNs_;
+    int64_t windowStartNs_ = 0;
+    int64_t currentMin_ = 0;
+    int64_t previousMin_ = 0;
+    bool haveCurrent_ = false;
+    bool havePrevious_ = false;
+};
+
+} // end namespace MorseCore
@@ -0,0 +1,236 @@
+#include "qso_text.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+// Longest over a walk may produce; the corpus never comes close, it
+// only stops a chain that loops on itself.
+const int MAX_OVER_WORDS = 120;
+
+// Word ids are packed 20 bits apiece into a context key.
+const uint32_t MAX_WORDS = 1u << 20;
+
+// The next word depends on the three before it and, for the first few
+// words, on its position: "<TO> DE <DE>" opens an over and also closes
+// one, and without the position an over could end as soon as it began.
+struct Context {
+    uint32_t words[3] = {0, 0, 0};
+    int position = 0;
+
+    uint64_t key() const {
+        return (static_cast<uint64_t>(words[0]) << 43) | (static_cast<uint64_t>(words[1]) << 23) |
+               (static_cast<uint64_t>(words[2]) << 3) | static_cast<uint64_t>(std::min(position, 7));
+    }
+    void push(uint32_t id) {
+        words[0] = words[1];
+        words[1] = words[2];
+        words[2] = id;
+        ++position;
+    }
+};
+
+} // namespace
+
+uint32_t QsoModel::wordId(const std::string& text) {
+    auto it = wordIds_.find(text);
+    if (it != wordIds_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(words_.size());
+    words_.push_back({text});
+    wordIds_.emplace(text, id);
+    return id;
+}
+
+bool QsoModel::load(const std::string& filename) {
+    CW_TRACE_SPAN("persist", "QsoModel::load");
+    *this = QsoModel();
+    words_.push_back({});   // start/end marker
+    std::ifstream fin(filename);
+    if (!fin) {
+        error_ = "could not read '" + filename + "'";
+        return false;
+    }
+
+    std::vector<std::vector<std::string>> shapeNames;
+    std::string line, section;
+    int lineNumber = 0;
+    while (std::getline(fin, line)) {
+        ++lineNumber;
+        std::istringstream in(line);
+        std::string first;
+        if (!(in >> first) || first[0] == '#') {
+            continue;
+        }
+        if (first == "=") {
+            shapeNames.emplace_back();
+            for (std::string name; in >> name;) shapeNames.back().push_back(name);
+            continue;
+        }
+        if (first.size() > 2 && first.front() == '[' && first.back() == ']') {
+            section = first.substr(1, first.size() - 2);
+            if (section != "values" && !sections_.count(section)) {
+                sections_[section] = chains_.size();
+                chains_.emplace_back();
+            }
+            continue;
+        }
+        if (section.empty()) {
+            error_ = filename + ":" + std::to_string(lineNumber) + ": text before the first [section]";
+            return false;
+        }
+        if (section == "values") {
+            valueNames_.push_back(first);
+            values_.emplace_back();
+            for (std::string v; in >> v;) values_.back().push_back(v);
+            continue;
+        }
+        Chain& chain = chains_[sections_[section]];
+        Context context;
+        for (std::string word = first; !word.empty(); word.clear(), in >> word) {
+            uint32_t id = wordId(word);
+            if (id >= MAX_WORDS) {
+                error_ = filename + ": more than " + std::to_string(MAX_WORDS) + " distinct words";
+                return false;
+            }
+            chain.next[context.key()].push_back(id);
+            context.push(id);
+        }
+        chain.next[context.key()].push_back(0);
+    }
+
+    for (const std::vector<std::string>& names : shapeNames) {
+        shapes_.emplace_back();
+        for (const std::string& name : names) {
+            auto it = sections_.find(name);
+            if (it == sections_.end() || chains_[it->second].next.empty()) {
+                error_ = filename + ": no overs in [" + name + "]";
+                return false;
+            }
+            shapes_.back().push_back(it->second);
+        }
+        if (shapes_.back().empty()) {
+            shapes_.pop_back();
+        }
+    }
+    if (shapes_.empty()) {
+        error_ = filename + ": no \"= ...\" QSO shapes";
+        return false;
+    }
+    return resolveSlots();
+}
+
+// <DE> and <TO> are the two calls, <NR> the sender's serial, <X> the
+// sender's value for a [values] line X and <TOX> the other station's.
+bool QsoModel::resolveSlots() {
+    auto valueIndex = [this](const std::string& name) -> int {
+        for (size_t i = 0; i < valueNames_.size(); ++i) {
+            if (valueNames_[i] == name && !values_[i].empty()) return static_cast<int>(i);
+        }
+        return -1;
+    };
+    for (Word& w : words_) {
+        if (w.text.size() < 3 || w.text.front() != '<' || w.text.back() != '>') {
+            continue;
+        }
+        std::string name = w.text.substr(1, w.text.size() - 2);
+        int index;
+        if (name == "DE") {
+            w.kind = Word::OwnCall;
+        } else if (name == "TO") {
+            w.kind = Word::OtherCall;
+        } else if (name == "NR") {
+            w.kind = Word::Serial;
+        } else if ((index = valueIndex(name)) >= 0) {
+            w.kind = Word::OwnValue;
+            w.values = index;
+        } else if (name.compare(0, 2, "TO") == 0 && (index = valueIndex(name.substr(2))) >= 0) {
+            w.kind = Word::OtherValue;
+            w.values = index;
+        } else {
+            error_ = "no [values] line for " + w.text;
+            return false;
+        }
+    }
+    return true;
+}
+
+QsoGenerator::QsoGenerator(const QsoModel& model, uint64_t seed)
+    : model_(model), rng_(seed), calls_(seed ^ 0x5EEDCA11u) {}
+
+size_t QsoGenerator::below(size_t n) {
+    return static_cast<size_t>(rng_() % n);
+}
+
+void QsoGenerator::startQso() {
+    shape_ = &model_.shapes_[below(model_.shapes_.size())];
+    overIndex_ = 0;
+    for (Station& s : stations_) {
+        s.call = calls_.next();
+        s.serial = 1 + static_cast<int>(below(1500));
+        s.picked.assign(model_.values_.size(), -1);
+    }
+}
+
+void QsoGenerator::append(std::string& out, const QsoModel::Word& word, Station& own, Station& other) {
+    Station* station = &own;
+    switch (word.kind) {
+        case QsoModel::Word::Text:      out += word.text; return;
+        case QsoModel::Word::OwnCall:   out += own.call; return;
+        case QsoModel::Word::OtherCall: out += other.call; return;
+        case QsoModel::Word::Serial:    out += std::to_string(own.serial); return;
+        case QsoModel::Word::OwnValue:  break;
+        case QsoModel::Word::OtherValue: station = &other; break;
+    }
+    // A station keeps its name, rig and so on for the whole QSO.
+    const std::vector<std::string>& choices = model_.values_[word.values];
+    int& pick = station->picked[word.values];
+    if (pick < 0) {
+        pick = static_cast<int>(below(choices.size()));
+    }
+    out += choices[pick];
+}
+
+std::string QsoGenerator::nextOver() {
+    CW_TRACE_SPAN("select", "nextOver");
+    if (!shape_ || overIndex_ >= shape_->size()) {
+        startQso();
+    }
+    const QsoModel::Chain& chain = model_.chains_[(*shape_)[overIndex_]];
+    Station& own = stations_[overIndex_ % 2];
+    Station& other = stations_[1 - overIndex_ % 2];
+    ++overIndex_;
+
+    std::string out;
+    Context context;
+    for (int n = 0; n < MAX_OVER_WORDS; ++n) {
+        auto it = chain.next.find(context.key());
+        if (it == chain.next.end()) break;
+        uint32_t id = it->second[below(it->second.size())];
+        if (id == 0) break;
+        if (!out.empty()) out += ' ';
+        append(out, model_.words_[id], own, other);
+        context.push(id);
+    }
+    return out;
+}
+
+std::string QsoGenerator::nextQso() {
+    CW_TRACE_SPAN("select", "nextQso");
+    shape_ = nullptr;
+    std::string qso;
+    do {
+        qso += nextOver();
+        qso += '\n';
+    } while (overIndex_ < shape_->size());
+    return qso;
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "callsign.h"
+
+// ------------------------------------------------------------
+// QSO text for copy practice. A QsoModel learns third-order word
+// chains from a corpus of real overs (see the qso_corpus file for
+// the format); a QsoGenerator walks them one over at a time and
+// fills in calls, reports, names and the like, so a session can
+// run as long as it likes without repeating itself.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+class QsoModel {
+public:
+    // Reads and checks a corpus; on failure error() says why.
+    bool load(const std::string& filename);
+    const std::string& error() const { return error_; }
+
+private:
+    friend class QsoGenerator;
+
+    // A word of an over: literal text, or a slot filled in per QSO.
+    struct Word {
+        std::string text;
+        enum Kind { Text, OwnCall, OtherCall, Serial, OwnValue, OtherValue } kind = Text;
+        size_t values = 0;         // index into values_ for the value kinds
+    };
+
+    // Successors of one context (see qso_text.cpp); a word that followed the
+    // context n times in the corpus appears n times.
+    struct Chain {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> next;
+    };
+
+    uint32_t wordId(const std::string& text);
+    bool resolveSlots();
+
+    std::vector<Word> words_;                 // id 0 marks the start and end of an over
+    std::unordered_map<std::string, uint32_t> wordIds_;
+    std::vector<Chain> chains_;
+    std::unordered_map<std::string, size_t> sections_;
+    std::vector<std::vector<size_t>> shapes_; // chains for each over of a QSO
+    std::vector<std::string> valueNames_;
+    std::vector<std::vector<std::string>> values_;
+    std::string error_;
+};
+
+class QsoGenerator {
+public:
+    // model must outlive the generator.
+    QsoGenerator(const QsoModel& model, uint64_t seed);
+
+    // The next over, starting a new QSO once the last one is over.
+    std::string nextOver();
+
+    // True when the over nextOver() last returned opened a QSO.
+    bool startedQso() const { return overIndex_ == 1; }
+
+    // A whole QSO, one over per line.
+    std::string nextQso();
+
+private:
+    struct Station {
+        std::string call;
+        int serial = 0;
+        std::vector<int> picked;   // chosen value per values_ entry, -1 = not yet
+    };
+
+    void startQso();
+    size_t below(size_t n);
+    void append(std::string& out, const QsoModel::Word& word, Station& own, Station& other);
+
+    const QsoModel& model_;
+    std::mt19937_64 rng_;
+    CallsignGenerator calls_;
+    Station stations_[2];
+    const std::vector<size_t>* shape_ = nullptr;
+    size_t overIndex_ = 0;
+};
+
+} // end namespace MorseCore
@@ -0,0 +1,163 @@
+#include "sending_analysis.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#include "morse_core.h"
+#include "trace.h"
+
+namespace MorseCore {
+
+namespace {
+
+double msBetween(SendingAnalyzer::Clock::time_point from, SendingAnalyzer::Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+GapStats summarize(std::vector<double> gaps) {
+    GapStats s;
+    s.count = static_cast<int>(gaps.size());
+    if (gaps.empty()) {
+        return s;
+    }
+    std::sort(gaps.begin(), gaps.end());
+    double sum = 0.0;
+    for (double g : gaps) sum += g;
+    s.meanMs = sum / gaps.size();
+    s.p50Ms = gaps[(gaps.size() - 1) / 2];
+    s.p90Ms = gaps[(gaps.size() - 1) * 9 / 10];
+    s.maxMs = gaps.back();
+    return s;
+}
+
+} // namespace
+
+void SendingAnalyzer::beginWord(Clock::time_point shown) {
+    endWord();
+    wordShown_ = shown;
+}
+
+void SendingAnalyzer::addChar(char c, Clock::time_point when, int keyerWpm) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    if (c == ' ') {
+        endWord();
+        return;
+    }
+    int units = characterUnits(c);
+    if (units == 0 || keyerWpm <= 0) {
+        return;
+    }
+    double unitMs = 1200.0 / keyerWpm;
+    double keyingMs = (units - 3) * unitMs;   // characterUnits() counts the gap after it
+    if (!inWord_) {
+        inWord_ = true;
+        wordGapsMs_.push_back(std::max(0.0, msBetween(wordShown_, when) - keyingMs));
+        firstEcho_ = when;
+        word_.assign(1, c);
+        wordUnits_ = units;
+        firstCharUnits_ = units;
+        wordWpm_ = keyerWpm;
+    } else {
+        double intervalMs = msBetween(lastEcho_, when);
+        if (intervalMs > 0.0) {
+            charSamples_.push_back({c, 1200.0 * units / intervalMs,
+                                    std::max(0.0, intervalMs - keyingMs)});
+        }
+        word_.push_back(c);
+        wordUnits_ += units;
+    }
+    lastEcho_ = when;
+}
+
+void SendingAnalyzer::endWord() {
+    CW_TRACE_SPAN("grade", "SendingAnalyzer::endWord");
+    if (!inWord_) {
+        return;
+    }
+    inWord_ = false;
+    wordShown_ = lastEcho_;
+    if (word_.size() < 2) {
+        return;   // a lone character is keyed at the keyer's speed by definition
+    }
+    double firstKeyingMs = (firstCharUnits_ - 3) * 1200.0 / wordWpm_;
+    double durationMs = msBetween(firstEcho_, lastEcho_) + firstKeyingMs;
+    if (durationMs > 0.0) {
+        words_.push_back({word_, 1200.0 * (wordUnits_ - 3) / durationMs});
+    }
+}
+
+SendingReport SendingAnalyzer::report(size_t maxHotspots) const {
+    SendingReport r;
+    std::vector<double> gaps;
+    gaps.reserve(charSamples_.size());
+    std::map<char, double> wpmSums;
+    std::map<char, double> gapSums;
+    for (const Sample& s : charSamples_) {
+        gaps.push_back(s.gapMs);
+        r.perChar[s.c].samples++;
+        wpmSums[s.c] += s.wpm;
+        gapSums[s.c] += s.gapMs;
+    }
+    for (auto& entry : r.perChar) {
+        entry.second.meanWpm = wpmSums[entry.first] / entry.second.samples;
+        entry.second.meanGapMs = gapSums[entry.first] / entry.second.samples;
+    }
+    r.characters = static_cast<int>(charSamples_.size() + wordGapsMs_.size());
+    r.words = words_;
+    r.charGaps = summarize(gaps);
+    r.wordGaps = summarize(wordGapsMs_);
+
+    // Characters the student pauses before: mean gap well above the median.
+    if (r.charGaps.p50Ms > 0.0) {
+        for (auto& entry : r.perChar) {
+            if (entry.second.samples < 2) continue;
+            double ratio = entry.second.meanGapMs / r.charGaps.p50Ms;
+            if (ratio > 1.25) {
+                r.hotspots.push_back({entry.first, entry.second.meanGapMs, ratio});
+            }
+        }
+        std::sort(r.hotspots.begin(), r.hotspots.end(),
+                  [](const Hesitation& a, const Hesitation& b) { return a.ratio > b.ratio; });
+        if (r.hotspots.size() > maxHotspots) {
+            r.hotspots.resize(maxHotspots);
+        }
+    }
+    return r;
+}
+
+std::map<char, CharSendingTotals> loadSendingStats(const std::string& filename) {
+    CW_TRACE_SPAN("persist", "loadSendingStats");
+    std::map<char, CharSendingTotals> stats;
+    std::ifstream fin(filename);
+    if (fin) {
+        char c;
+        CharSendingTotals t;
+        while (fin >> c >> t.samples >> t.wpmSum >> t.gapMsSum) {
+            stats[c] = t;
+        }
+    }
+    return stats;
+}
+
+void saveSendingStats(const std::map<char, CharSendingTotals>& stats, const std::string& filename) {
+    CW_TRACE_SPAN("persist", "saveSendingStats");
+    std::ofstream fout(filename);
+    if (fout) {
+        for (auto &entry : stats) {
+            fout << entry.first << " " << entry.second.samples << " "
+                 << entry.second.wpmSum << " " << entry.second.gapMsSum << "\n";
+        }
+    }
+}
+
+void mergeSendingStats(std::map<char, CharSendingTotals>& stats, const SendingReport& report) {
+    for (auto &entry : report.perChar) {
+        CharSendingTotals& t = stats[entry.first];
+        t.samples += entry.second.samples;
+        t.wpmSum += entry.second.meanWpm * entry.second.samples;
+        t.gapMsSum += entry.second.meanGapMs * entry.second.samples;
+    }
+}
+
+} // end namespace MorseCore
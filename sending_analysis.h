@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Sending analysis. The sending modes feed in every character the
+// keyer echoes, with its arrival time; the analyzer turns those
+// into speed, rhythm and hesitation figures for the session.
+//
+// With an iambic keyer the dots and dashes are always timed at the
+// keyer's speed, so what the student controls are the gaps. The
+// time between two echoes is the keying time of the second
+// character plus the gap before it; the gap is what is left once
+// the keying time at the keyer's speed is taken away.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+struct GapStats {
+    int count = 0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p90Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+struct CharSending {
+    int samples = 0;
+    double meanWpm = 0.0;      // speed over the gap before it plus its keying
+    double meanGapMs = 0.0;    // gap before it (inter-character only)
+};
+
+struct WordSending {
+    std::string word;
+    double wpm;
+};
+
+struct Hesitation {
+    char c;
+    double meanGapMs;
+    double ratio;              // mean gap / median inter-character gap
+};
+
+struct SendingReport {
+    int characters = 0;
+    std::map<char, CharSending> perChar;
+    std::vector<WordSending> words;
+    GapStats charGaps;
+    GapStats wordGaps;         // before the first character of each word
+    std::vector<Hesitation> hotspots;  // worst first
+};
+
+class SendingAnalyzer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A new word is on screen from `shown`.
+    void beginWord(Clock::time_point shown);
+    Clock::time_point wordShown() const { return wordShown_; }
+    // An echoed character; keyerWpm is the keyer's speed when it was sent.
+    void addChar(char c, Clock::time_point when, int keyerWpm);
+    // Closes the current word (a space or the end of an item).
+    void endWord();
+
+    SendingReport report(size_t maxHotspots = 5) const;
+
+private:
+    struct Sample {
+        char c;
+        double wpm;
+        double gapMs;
+    };
+
+    std::vector<Sample> charSamples_;
+    std::vector<double> wordGapsMs_;
+    std::vector<WordSending> words_;
+
+    Clock::time_point wordShown_;
+    Clock::time_point lastEcho_;
+    Clock::time_point firstEcho_;
+    std::string word_;
+    int wordUnits_ = 0;
+    int firstCharUnits_ = 0;
+    int wordWpm_ = 20;
+    bool inWord_ = false;
+};
+
+// All-time per-character totals, one "CHAR SAMPLES WPMSUM GAPSUM" line each.
+struct CharSendingTotals {
+    int samples = 0;
+    double wpmSum = 0.0;
+    double gapMsSum = 0.0;
+};
+
+std::map<char, CharSendingTotals> loadSendingStats(const std::string& filename);
+void saveSendingStats(const std::map<char, CharSendingTotals>& stats, const std::string& filename);
+void mergeSendingStats(std::map<char, CharSendingTotals>& stats, const SendingReport& report);
+
+} // end namespace MorseCore
@@ -0,0 +1,88 @@
+#include "speed_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "trace.h"
+
+namespace MorseCore {
+
+SpeedController::SpeedController(const SpeedControllerConfig& config)
+    : config_(config),
+      wpm_(std::max(config.minWpm, std::min(config.maxWpm, config.wpm))),
+      effectiveWpm_(std::max(1, std::min(wpm_, config.effectiveWpm))),
+      // Start on target, so the first few answers cannot swing it.
+      accuracy_(config.targetAccuracy),
+      latency_(config.targetLatencySec) {}
+
+bool SpeedController::record(bool correct, double responseSec) {
+    const double a = config_.alpha;
+    accuracy_ += a * ((correct ? 1.0 : 0.0) - accuracy_);
+    if (responseSec >= 0.0) {
+        // One long pause (a sneeze, a phone) should not count as three.
+        double clipped = std::min(responseSec, 3.0 * config_.targetLatencySec);
+        latency_ += a * (clipped - latency_);
+    }
+    ++sinceChange_;
+
+    bool changed = false;
+    if (sinceChange_ >= config_.holdItems) {
+        double slowLatency = config_.targetLatencySec * (1.0 + config_.latencyBand);
+        double quickLatency = config_.targetLatencySec * (1.0 - config_.latencyBand);
+        if (accuracy_ < config_.targetAccuracy - config_.accuracyBand || latency_ > slowLatency) {
+            changed = slower();
+        } else if (accuracy_ > config_.targetAccuracy + config_.accuracyBand && latency_ < quickLatency) {
+            changed = faster();
+        }
+        if (changed) sinceChange_ = 0;
+    }
+    trajectory_.push_back({static_cast<int>(trajectory_.size()) + 1, correct, responseSec,
+                           accuracy_, latency_, wpm_, effectiveWpm_});
+    return changed;
+}
+
+bool SpeedController::faster() {
+    if (effectiveWpm_ < wpm_) {
+        effectiveWpm_ = std::min(wpm_, effectiveWpm_ + config_.step);
+        return true;
+    }
+    if (wpm_ < config_.maxWpm) {
+        wpm_ = std::min(config_.maxWpm, wpm_ + config_.step);
+        effectiveWpm_ = wpm_;
+        return true;
+    }
+    return false;
+}
+
+bool SpeedController::slower() {
+    int floor = std::max(1, static_cast<int>(std::lround(wpm_ * config_.minSpacing)));
+    if (effectiveWpm_ > floor) {
+        effectiveWpm_ = std::max(floor, effectiveWpm_ - config_.step);
+        return true;
+    }
+    if (wpm_ > config_.minWpm) {
+        wpm_ = std::max(config_.minWpm, wpm_ - config_.step);
+        effectiveWpm_ = std::min(effectiveWpm_, wpm_);
+        return true;
+    }
+    return false;
+}
+
+bool SpeedController::appendTrajectory(const std::string& filename, const std::string& session) const {
+    CW_TRACE_SPAN("persist", "appendTrajectory");
+    bool isNew = !std::ifstream(filename).good();
+    std::ofstream out(filename, std::ios::app);
+    if (!out) return false;
+    if (isNew) {
+        out << "session,item,correct,response_sec,accuracy,latency_sec,wpm,effective_wpm\n";
+    }
+    for (const SpeedStep& s : trajectory_) {
+        out << session << ',' << s.item << ',' << (s.correct ? 1 : 0) << ',';
+        if (s.responseSec >= 0.0) out << s.responseSec;
+        out << ',' << s.accuracy << ',' << s.latencySec << ',' << s.wpm << ',' << s.effectiveWpm << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Adaptive speed. The controller is fed every answer and keeps
+// exponentially weighted averages of accuracy and response time;
+// when they leave a band around the target it moves the speed one
+// step. Spacing goes first: speeding up closes the Farnsworth gap
+// before the characters themselves get faster, and slowing down
+// widens it before they get slower. The dead band plus a hold of
+// a few items after every change keeps it from see-sawing.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+struct SpeedControllerConfig {
+    int wpm = 20;                  // starting speeds
+    int effectiveWpm = 10;
+    int minWpm = 5;
+    int maxWpm = 50;
+    double minSpacing = 0.5;       // Farnsworth floor, as a fraction of wpm
+    int step = 1;                  // WPM per change
+    double targetAccuracy = 0.9;
+    double accuracyBand = 0.05;    // no change within target +/- band
+    double targetLatencySec = 1.5; // answers slower than this mean struggling
+    double latencyBand = 0.25;     // relative dead band around the target
+    double alpha = 0.1;            // weight of the newest answer
+    int holdItems = 5;             // answers after a change before the next
+};
+
+struct SpeedStep {
+    int item;              // 1-based
+    bool correct;
+    double responseSec;    // < 0 when not measured
+    double accuracy;       // averages after this answer
+    double latencySec;
+    int wpm;               // speed for the next item
+    int effectiveWpm;
+};
+
+class SpeedController {
+public:
+    explicit SpeedController(const SpeedControllerConfig& config);
+
+    // Feeds one answer; true if the speed changed. A negative
+    // responseSec leaves the latency average alone.
+    bool record(bool correct, double responseSec);
+
+    int wpm() const { return wpm_; }
+    int effectiveWpm() const { return effectiveWpm_; }
+    double accuracy() const { return accuracy_; }
+    double latencySec() const { return latency_; }
+    const std::vector<SpeedStep>& trajectory() const { return trajectory_; }
+
+    // Appends the trajectory as CSV rows tagged with `session`,
+    // writing the header first if the file is new.
+    bool appendTrajectory(const std::string& filename, const std::string& session) const;
+
+private:
+    bool faster();
+    bool slower();
+
+    SpeedControllerConfig config_;
+    int wpm_;
+    int effectiveWpm_;
+    double accuracy_;
+    double latency_;
+    int sinceChange_ = 0;
+    std::vector<SpeedStep> trajectory_;
+};
+
+} // end namespace MorseCore
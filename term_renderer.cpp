@@ -0,0 +1,129 @@
+#include "term_renderer.h"
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+TermRenderer::TermRenderer(int fd) : fd_(fd) {
+    querySize();
+}
+
+void TermRenderer::querySize() {
+    struct winsize ws;
+    if (ioctl(fd_, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        if (ws.ws_row != rows_ || ws.ws_col != cols_) {
+            frontKnown_ = false;
+        }
+        rows_ = ws.ws_row;
+        cols_ = ws.ws_col;
+    }
+    size_t cells = static_cast<size_t>(rows_) * cols_;
+    if (back_.size() != cells) {
+        back_.assign(cells, ' ');
+        front_.assign(cells, ' ');
+        frontKnown_ = false;
+    }
+}
+
+void TermRenderer::clear() {
+    querySize();
+    std::fill(back_.begin(), back_.end(), ' ');
+    cursorRow_ = 0;
+    cursorCol_ = 0;
+}
+
+void TermRenderer::print(int row, int col, const std::string& text) {
+    int c = col;
+    for (char ch : text) {
+        if (ch == '\n') {
+            ++row;
+            c = col;
+            continue;
+        }
+        if (row >= 0 && row < rows_ && c >= 0 && c < cols_) {
+            back_[static_cast<size_t>(row) * cols_ + c] = ch;
+        }
+        ++c;
+    }
+    cursorRow_ = row;
+    cursorCol_ = c;
+}
+
+void TermRenderer::setCursor(int row, int col) {
+    cursorRow_ = row;
+    cursorCol_ = col;
+}
+
+void TermRenderer::present() {
+    std::string out;
+    if (!frontKnown_) {
+        out += "\033[H\033[2J";
+        std::fill(front_.begin(), front_.end(), ' ');
+        frontKnown_ = true;
+    }
+    // Bottom-right cell is skipped: writing it makes many terminals scroll.
+    size_t last = back_.size() - 1;
+    for (int r = 0; r < rows_; ++r) {
+        int c = 0;
+        while (c < cols_) {
+            size_t i = static_cast<size_t>(r) * cols_ + c;
+            if (i >= last || back_[i] == front_[i]) {
+                ++c;
+                continue;
+            }
+            // Extend the run over changed cells, bridging short unchanged
+            // gaps where resending is cheaper than another cursor move.
+            int end = c + 1;
+            int gap = 0;
+            while (end < cols_ && static_cast<size_t>(r) * cols_ + end < last && gap < 6) {
+                size_t j = static_cast<size_t>(r) * cols_ + end;
+                gap = (back_[j] == front_[j]) ? gap + 1 : 0;
+                ++end;
+            }
+            end -= gap;
+            out += "\033[" + std::to_string(r + 1) + ";" + std::to_string(c + 1) + "H";
+            out.append(&back_[i], end - c);
+            std::copy(back_.begin() + i, back_.begin() + i + (end - c), front_.begin() + i);
+            c = end;
+        }
+    }
+    // Writing cells moves the real cursor, so it is put back after any.
+    if (out.empty() && cursorRow_ == shownRow_ && cursorCol_ == shownCol_) {
+        return;
+    }
+    out += "\033[" + std::to_string(cursorRow_ + 1) + ";" + std::to_string(cursorCol_ + 1) + "H";
+    shownRow_ = cursorRow_;
+    shownCol_ = cursorCol_;
+    flushOut(out);
+}
+
+void TermRenderer::clearScreen() {
+    flushOut("\033[H\033[2J");
+    frontKnown_ = false;
+    shownRow_ = -1;
+    shownCol_ = -1;
+}
+
+void TermRenderer::flushOut(const std::string& out) {
+    // Anything still buffered in the streams must reach the terminal first.
+    std::cout.flush();
+    std::fflush(stdout);
+    size_t written = 0;
+    while (written < out.size()) {
+        ssize_t n = write(fd_, out.data() + written, out.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+TermRenderer& terminal() {
+    static TermRenderer renderer(STDOUT_FILENO);
+    return renderer;
+}
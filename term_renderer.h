@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Double-buffered terminal renderer. A frame is drawn into the
+// back buffer; present() compares it with what is on screen and
+// sends only the changed cells, as ANSI cursor moves plus text,
+// in a single write(). Redrawing an unchanged screen with the
+// cursor where it was costs no output at all.
+// ------------------------------------------------------------
+class TermRenderer {
+public:
+    explicit TermRenderer(int fd);
+
+    // Blanks the back buffer (re-reading the window size).
+    void clear();
+    // Writes text at row/col (0-based); '\n' continues on the next
+    // row at the same column. Text past the edge is clipped.
+    void print(int row, int col, const std::string& text);
+    // Where the cursor is left after present().
+    void setCursor(int row, int col);
+
+    // Sends the differences between the back buffer and the screen.
+    void present();
+
+    // Clears the real screen and homes the cursor without spawning a
+    // shell. Anything printed afterwards by other means is unknown to
+    // the renderer, so the next present() repaints in full.
+    void clearScreen();
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+private:
+    void querySize();
+    void flushOut(const std::string& out);
+
+    int fd_;
+    int rows_ = 24;
+    int cols_ = 80;
+    int cursorRow_ = 0;
+    int cursorCol_ = 0;
+    int shownRow_ = -1;   // cursor position last sent; -1 if unknown
+    int shownCol_ = -1;
+    bool frontKnown_ = false;
+    std::vector<char> back_;
+    std::vector<char> front_;
+};
+
+// Renderer for the controlling terminal (stdout).
+TermRenderer& terminal();
@@ -0,0 +1,140 @@
+#include "text_follower.h"
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// A writer that never sends a newline still gets heard, a line's
+// worth at a time.
+const size_t MAX_LINE = 4096;
+
+const uint32_t WATCHED = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+
+} // namespace
+
+TextFollower::~TextFollower() {
+    stop();
+    if (fileFd_ >= 0) close(fileFd_);
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+}
+
+bool TextFollower::open(const std::string& path) {
+    path_ = path;
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    name_ = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name_.empty()) {
+        error_ = path + " is not a file name";
+        return false;
+    }
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        error_ = std::string("inotify: ") + strerror(errno);
+        return false;
+    }
+    if (inotify_add_watch(inotifyFd_, dir.c_str(), WATCHED) < 0) {
+        error_ = "Cannot watch " + dir + ": " + strerror(errno);
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        return false;
+    }
+    reopen(true);
+    return true;
+}
+
+bool TextFollower::start(EventLoop& loop, LineHandler handler) {
+    loop_ = &loop;
+    handler_ = std::move(handler);
+    if (!loop.watch(inotifyFd_, [this](uint32_t) { onEvents(); })) {
+        error_ = "Cannot add the inotify watch to the event loop";
+        loop_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void TextFollower::stop() {
+    if (!loop_) return;
+    loop_->unwatch(inotifyFd_);
+    loop_ = nullptr;
+}
+
+void TextFollower::onEvents() {
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t n = read(inotifyFd_, buffer, sizeof(buffer));
+        if (n <= 0) return;
+        for (char* p = buffer; p < buffer + n;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                readAppended(false);
+                continue;
+            }
+            if (event->len == 0 || name_ != event->name) continue;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                // A new file under the name: all of it is new text.
+                reopen(false);
+                readAppended(false);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                // Rotated away; finish what was written and wait for
+                // the replacement.
+                readAppended(true);
+                if (fileFd_ >= 0) close(fileFd_);
+                fileFd_ = -1;
+            } else {
+                readAppended((event->mask & IN_CLOSE_WRITE) != 0);
+            }
+            if (!loop_) return;   // the handler stopped us
+        }
+    }
+}
+
+void TextFollower::reopen(bool atEnd) {
+    if (fileFd_ >= 0) close(fileFd_);
+    fileFd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    offset_ = 0;
+    partial_.clear();
+    struct stat st;
+    if (atEnd && fileFd_ >= 0 && fstat(fileFd_, &st) == 0) {
+        offset_ = st.st_size;
+    }
+}
+
+void TextFollower::readAppended(bool flushPartial) {
+    if (fileFd_ < 0) reopen(false);
+    if (fileFd_ < 0) return;
+    struct stat st;
+    if (fstat(fileFd_, &st) == 0 && st.st_size < offset_) {
+        // Truncated in place: start over from the top.
+        offset_ = 0;
+        partial_.clear();
+    }
+    char buffer[65536];
+    ssize_t n;
+    while ((n = pread(fileFd_, buffer, sizeof(buffer), offset_)) > 0) {
+        offset_ += n;
+        for (ssize_t i = 0; i < n; ++i) {
+            char c = buffer[i];
+            if (c == '\n' || partial_.size() >= MAX_LINE) {
+                if (!partial_.empty() && partial_.back() == '\r') partial_.pop_back();
+                std::string line;
+                line.swap(partial_);
+                if (handler_) handler_(line);
+                if (c == '\n') continue;
+            }
+            partial_ += c;
+        }
+    }
+    if (flushPartial && !partial_.empty()) {
+        std::string line;
+        line.swap(partial_);
+        if (handler_) handler_(line);
+    }
+}
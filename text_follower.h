@@ -0,0 +1,48 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <functional>
+#include <string>
+
+#include "event_loop.h"
+
+// ------------------------------------------------------------
+// tail -f for the follow mode: hands each line appended to a text
+// file to a callback on the event loop's thread. An inotify watch
+// on the file's directory wakes the loop on every write, so a line
+// is delivered as soon as it lands rather than at the next poll.
+// Watching the directory rather than the file also catches the
+// file being created later, replaced (log rotation) or truncated.
+// ------------------------------------------------------------
+using LineHandler = std::function<void(const std::string& line)>;
+
+class TextFollower {
+public:
+    TextFollower() = default;
+    ~TextFollower();
+    TextFollower(const TextFollower&) = delete;
+    TextFollower& operator=(const TextFollower&) = delete;
+
+    // Starts at the current end of the file, like tail -f; the file
+    // need not exist yet.
+    bool open(const std::string& path);
+    bool start(EventLoop& loop, LineHandler handler);
+    void stop();
+    const std::string& error() const { return error_; }
+
+private:
+    void onEvents();
+    void reopen(bool atEnd);
+    void readAppended(bool flushPartial);
+
+    std::string path_;
+    std::string name_;          // file name within the watched directory
+    int inotifyFd_ = -1;
+    int fileFd_ = -1;
+    off_t offset_ = 0;
+    std::string partial_;       // text after the last newline
+    EventLoop* loop_ = nullptr;
+    LineHandler handler_;
+    std::string error_;
+};
@@ -0,0 +1,233 @@
+// Renders text to an audio file as fast as the disk takes it, for
+// practice away from the trainer (a phone, a car) or in a pipeline.
+//
+// Usage: cw_export [--wpm N] [--farnsworth N] [--pitch HZ] [--rate HZ]
+//                  [-o OUTPUT] [INPUT]
+//
+// INPUT defaults to stdin and OUTPUT to stdout. The format follows
+// the output's extension: .wav always, .flac and .ogg (Vorbis) when
+// built with SFML. Stdout gets WAV, so
+//
+//   fortune | cw_export --wpm 25 | flac -o fortune.flac -
+//
+// works without SFML. Text is read, rendered and written a block at
+// a time, so memory use is the same for a line or a book. Runs of
+// whitespace become one word gap; characters with no Morse code are
+// skipped.
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef CW_HAVE_SFML
+#include <SFML/Audio.hpp>
+#endif
+
+#include "morse_core.h"
+#include "wav_writer.h"
+
+namespace {
+
+class Sink {
+public:
+    virtual ~Sink() = default;
+    virtual bool write(const short* samples, size_t count) = 0;
+    virtual bool close() = 0;
+    virtual std::string error() const = 0;
+};
+
+class WavSink : public Sink {
+public:
+    bool open(const std::string& path, int sampleRate) { return writer_.open(path, sampleRate); }
+    bool write(const short* samples, size_t count) override { return writer_.write(samples, count); }
+    bool close() override { return writer_.close(); }
+    std::string error() const override { return writer_.error(); }
+
+private:
+    MorseCore::WavWriter writer_;
+};
+
+#ifdef CW_HAVE_SFML
+// SFML picks the encoder (FLAC, Vorbis) from the file name and encodes
+// each block as it is written.
+class SfmlSink : public Sink {
+public:
+    bool open(const std::string& path, int sampleRate) {
+        file_.reset(new sf::OutputSoundFile);
+        if (!file_->openFromFile(path, static_cast<unsigned int>(sampleRate), 1)) {
+            error_ = "SFML could not write '" + path + "'";
+            file_.reset();
+            return false;
+        }
+        return true;
+    }
+    bool write(const short* samples, size_t count) override {
+        file_->write(samples, count);
+        return true;
+    }
+    bool close() override {
+        file_.reset();   // the destructor flushes the encoder
+        return true;
+    }
+    std::string error() const override { return error_; }
+
+private:
+    std::unique_ptr<sf::OutputSoundFile> file_;
+    std::string error_;
+};
+#endif
+
+std::string extensionOf(const std::string& path) {
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos || path.find('/', dot) != std::string::npos) {
+        return "";
+    }
+    std::string ext = path.substr(dot + 1);
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext;
+}
+
+std::unique_ptr<Sink> openSink(const std::string& path, int sampleRate, std::string& error) {
+    std::string ext = extensionOf(path);
+    if (path == "-" || ext == "wav") {
+        std::unique_ptr<WavSink> sink(new WavSink);
+        if (!sink->open(path, sampleRate)) {
+            error = sink->error();
+            return nullptr;
+        }
+        return std::unique_ptr<Sink>(sink.release());
+    }
+    if (ext == "flac" || ext == "ogg") {
+#ifdef CW_HAVE_SFML
+        std::unique_ptr<SfmlSink> sink(new SfmlSink);
+        if (!sink->open(path, sampleRate)) {
+            error = sink->error();
+            return nullptr;
+        }
+        return std::unique_ptr<Sink>(sink.release());
+#else
+        error = "this build has no SFML, so only .wav or stdout; pipe stdout into flac or oggenc instead";
+        return nullptr;
+#endif
+    }
+    error = "unknown output format '" + path + "' (use .wav, .flac or .ogg)";
+    return nullptr;
+}
+
+void usage() {
+    std::cerr << "Usage: cw_export [--wpm N] [--farnsworth N] [--pitch HZ] [--rate HZ]\n"
+              << "                 [-o OUTPUT.wav|.flac|.ogg] [INPUT]\n";
+}
+
+std::string formatDuration(double seconds) {
+    long s = static_cast<long>(seconds + 0.5);
+    std::ostringstream out;
+    out << std::setfill('0') << std::setw(2) << s / 3600 << ":" << std::setw(2) << s / 60 % 60
+        << ":" << std::setw(2) << s % 60;
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int wpm = 20;
+    int farnsworth = 0;
+    float pitch = 800.0f;
+    int sampleRate = MorseCore::SAMPLE_RATE;
+    std::string inputPath = "-";
+    std::string outputPath = "-";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--wpm" && i + 1 < argc) {
+            wpm = std::atoi(argv[++i]);
+        } else if (arg == "--farnsworth" && i + 1 < argc) {
+            farnsworth = std::atoi(argv[++i]);
+        } else if (arg == "--pitch" && i + 1 < argc) {
+            pitch = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--rate" && i + 1 < argc) {
+            sampleRate = std::atoi(argv[++i]);
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg[0] != '-' || arg == "-") {
+            inputPath = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (farnsworth <= 0 || farnsworth > wpm) {
+        farnsworth = wpm;
+    }
+    if (wpm <= 0 || sampleRate < 8000 || pitch <= 0 || pitch >= sampleRate / 2) {
+        usage();
+        return 2;
+    }
+
+    std::FILE* input = inputPath == "-" ? stdin : std::fopen(inputPath.c_str(), "rb");
+    if (!input) {
+        std::cerr << "cw_export: cannot read " << inputPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::string error;
+    std::unique_ptr<Sink> sink = openSink(outputPath, sampleRate, error);
+    if (!sink) {
+        std::cerr << "cw_export: " << error << "\n";
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    MorseCore::Timing timing = MorseCore::makeTiming(wpm, farnsworth, sampleRate);
+    std::vector<char> block(64 * 1024);
+    std::vector<short> samples(8192);
+    std::string text;
+    bool afterSpace = true;   // also drops leading whitespace
+    uint64_t characters = 0;
+    uint64_t written = 0;
+    size_t n;
+    while ((n = std::fread(block.data(), 1, block.size(), input)) > 0) {
+        text.clear();
+        for (size_t i = 0; i < n; ++i) {
+            char c = block[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                if (!afterSpace) text += ' ';
+                afterSpace = true;
+            } else if (MorseCore::lookup(c)) {
+                text += c;
+                afterSpace = false;
+                ++characters;
+            }
+        }
+        MorseCore::MessageRenderer renderer(text, pitch, timing);
+        size_t got;
+        while ((got = renderer.render(samples.data(), samples.size())) > 0) {
+            if (!sink->write(samples.data(), got)) {
+                std::cerr << "cw_export: " << sink->error() << "\n";
+                return 1;
+            }
+            written += got;
+        }
+    }
+    if (input != stdin) {
+        std::fclose(input);
+    }
+    if (!sink->close()) {
+        std::cerr << "cw_export: " << sink->error() << "\n";
+        return 1;
+    }
+
+    double audioSec = static_cast<double>(written) / sampleRate;
+    double tookSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << "cw_export: " << characters << " characters, " << formatDuration(audioSec)
+              << " of audio in " << std::fixed << std::setprecision(2) << tookSec << " s ("
+              << std::setprecision(0) << audioSec / std::max(tookSec, 1e-6) << "x real time)\n";
+    return 0;
+}
@@ -0,0 +1,453 @@
+// Software WinKeyer on a pseudo-terminal, for running the sending
+// modes without a K1EL keyer attached.
+//
+// Usage: wk_emulator [--link PATH] [--script FILE] [--verbose]
+//
+// Prints the pty path on startup; point the trainer at it with
+// --device (or CW_WINKEYER_DEVICE). --link also makes a symlink to it
+// at a fixed path. The host-mode commands the trainer sends are
+// parsed and applied; text sent by the host is keyed out in real time
+// through a 128-byte buffer with XOFF/BUSY status, just like the
+// hardware, and KEYDOWN follows every element keyed, host or paddle.
+// Paddle echo, speed pot and status bytes come from the
+// script, which starts when the host opens the keyer, one step per line:
+//
+//   wait MS         pause
+//   send TEXT       paddle-sent text, echoed at the current speed
+//   pot N           speed pot byte with position N (0-31)
+//   status 0xNN     raw status byte
+//   raw 0xNN ...    arbitrary bytes
+//   quit            exit
+//
+// Blank lines and lines starting with '#' are ignored.
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "event_loop.h"
+#include "morse_core.h"
+#include "winkeyer_core.h"
+
+namespace {
+
+using Clock = EventLoop::Clock;
+
+const unsigned char FIRMWARE_VERSION = 23;
+const size_t BUFFER_SIZE = 128;
+const size_t XOFF_LEVEL = BUFFER_SIZE * 2 / 3;
+
+volatile sig_atomic_t interrupted = 0;
+
+void onSignal(int) {
+    interrupted = 1;
+}
+
+struct Step {
+    std::string op;
+    std::string arg;
+};
+
+bool loadScript(const std::string& path, std::vector<Step>& steps) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        std::istringstream ls(line.substr(start));
+        Step step;
+        ls >> step.op;
+        std::getline(ls >> std::ws, step.arg);
+        steps.push_back(step);
+    }
+    return true;
+}
+
+class Emulator {
+public:
+    Emulator(int master, std::vector<Step> script, bool verbose)
+        : master_(master), script_(std::move(script)), verbose_(verbose) {}
+
+    int run() {
+        loop_.watch(master_, [this](uint32_t) { onInput(); });
+        while (!loop_.stopped() && !interrupted) {
+            loop_.runOnce();
+        }
+        return 0;
+    }
+
+private:
+    // --- bytes to the host ---
+
+    void writeByte(unsigned char b) {
+        while (write(master_, &b, 1) < 0 && errno == EINTR) {
+        }
+    }
+
+    // Outside host mode the keyer keeps quiet.
+    void emit(unsigned char b) {
+        if (hostOpen_) writeByte(b);
+    }
+
+    void setStatus(unsigned char bits, bool on) {
+        unsigned char next = on ? (status_ | bits) : (status_ & ~bits);
+        if (next != status_) {
+            status_ = next;
+            emit(0xC0 | status_);
+        }
+    }
+
+    int unitMs() const {
+        return 1200 / (wpm_ > 0 ? wpm_ : 1);
+    }
+
+    // --- host commands ---
+
+    void onInput() {
+        unsigned char buf[256];
+        ssize_t n = read(master_, buf, sizeof(buf));
+        if (n <= 0) {
+            return;
+        }
+        for (ssize_t i = 0; i < n; ++i) {
+            feed(buf[i]);
+        }
+    }
+
+    // Number of parameter bytes after a command byte; -1 until known.
+    int paramCount() const {
+        unsigned char cmd = pending_[0];
+        switch (cmd) {
+        case 0x00:
+            if (pending_.size() < 2) return -1;
+            return pending_[1] == 0x04 ? 2 : 1;   // echo test carries a byte
+        case 0x04: case 0x1B:
+            return 2;
+        case 0x05:
+            return 3;
+        case 0x0F:
+            return 15;
+        case 0x07: case 0x08: case 0x0A: case 0x13: case 0x15: case 0x1E: case 0x1F:
+            return 0;
+        default:
+            return 1;
+        }
+    }
+
+    void feed(unsigned char b) {
+        if (pending_.empty() && b >= 0x20) {
+            queueText(static_cast<char>(b));
+            return;
+        }
+        pending_.push_back(b);
+        int params = paramCount();
+        if (params < 0 || static_cast<int>(pending_.size()) < params + 1) {
+            return;
+        }
+        execute();
+        pending_.clear();
+    }
+
+    void execute() {
+        const std::vector<unsigned char>& c = pending_;
+        if (verbose_) {
+            std::cerr << "cmd";
+            for (unsigned char b : c) {
+                char hex[8];
+                snprintf(hex, sizeof(hex), " %02X", b);
+                std::cerr << hex;
+            }
+            std::cerr << "\n";
+        }
+        switch (c[0]) {
+        case 0x00:
+            if (c[1] == 0x02) {
+                hostOpen_ = true;
+                status_ = 0;
+                emit(FIRMWARE_VERSION);
+                if (!scriptStarted_) {
+                    scriptStarted_ = true;
+                    nextStep();
+                }
+            } else if (c[1] == 0x03) {
+                hostOpen_ = false;
+                clearBuffer();
+            } else if (c[1] == 0x04) {
+                writeByte(c[2]);
+            }
+            break;
+        case 0x02:
+        case 0x1C:
+            if (c[1] > 0) wpm_ = c[1];
+            break;
+        case 0x05:
+            potMin_ = c[1];
+            potRange_ = c[2];
+            break;
+        case 0x07:
+            emit(0x80 | (potPos_ & 0x3F));
+            break;
+        case 0x09:
+            pinCfg_ = c[1];
+            break;
+        case 0x0A:
+            clearBuffer();
+            break;
+        case 0x0E:
+            mode_ = c[1];
+            break;
+        case 0x15:
+            emit(0xC0 | status_);
+            break;
+        default:
+            // Weighting, PTT timing, Farnsworth, key compensation, ratio
+            // and the rest only change how the keyer shapes its output.
+            break;
+        }
+    }
+
+    // --- host text, keyed out through the buffer ---
+
+    void queueText(char ch) {
+        if (buffer_.size() >= BUFFER_SIZE) {
+            return;   // overrun: the real keyer drops it too
+        }
+        buffer_.push_back(ch);
+        setStatus(WinKeyerCore::STATUS_XOFF, buffer_.size() > XOFF_LEVEL);
+        if (hostKeying_.timer < 0) {
+            sendNext();
+        }
+    }
+
+    void sendNext() {
+        if (buffer_.empty()) {
+            setStatus(WinKeyerCore::STATUS_BUSY, false);
+            return;
+        }
+        char ch = buffer_.front();
+        buffer_.pop_front();
+        setStatus(WinKeyerCore::STATUS_XOFF, buffer_.size() > XOFF_LEVEL);
+        setStatus(WinKeyerCore::STATUS_BUSY, true);
+        keyChar(hostKeying_, ch, [this, ch] {
+            if (mode_ & 0x04) emit(static_cast<unsigned char>(ch));   // serial echo
+            sendNext();
+        });
+    }
+
+    // One character being keyed, element by element.
+    struct Keying {
+        std::string elements;
+        size_t next = 0;
+        bool down = false;
+        EventLoop::TimerId timer = -1;
+        std::function<void()> done;
+    };
+
+    // Keys ch, reporting KEYDOWN on each change, and calls done after
+    // the gap that ends the character; the total matches characterUnits.
+    void keyChar(Keying& k, char ch, std::function<void()> done) {
+        const char* pattern = MorseCore::lookup(ch);
+        k.elements = pattern ? pattern : "";
+        k.next = 0;
+        k.down = false;
+        k.done = std::move(done);
+        if (k.elements.empty()) {
+            keyAfter(k, MorseCore::characterUnits(ch));
+        } else {
+            keyStep(k);
+        }
+    }
+
+    void keyStep(Keying& k) {
+        k.timer = -1;
+        if (k.down) {
+            k.down = false;
+            setStatus(WinKeyerCore::STATUS_KEYDOWN, false);
+            // The last element's trailing unit is part of the 3-unit gap.
+            keyAfter(k, ++k.next < k.elements.size() ? 1 : 3);
+        } else if (k.next < k.elements.size()) {
+            k.down = true;
+            setStatus(WinKeyerCore::STATUS_KEYDOWN, true);
+            keyAfter(k, k.elements[k.next] == '-' ? 3 : 1);
+        } else {
+            std::function<void()> done = std::move(k.done);
+            done();
+        }
+    }
+
+    void keyAfter(Keying& k, int units) {
+        k.timer = loop_.addTimer(Clock::now() + std::chrono::milliseconds(units * unitMs()),
+                                 [this, &k] { keyStep(k); });
+    }
+
+    void clearBuffer() {
+        buffer_.clear();
+        if (hostKeying_.timer >= 0) {
+            loop_.cancelTimer(hostKeying_.timer);
+            hostKeying_.timer = -1;
+        }
+        setStatus(WinKeyerCore::STATUS_XOFF | WinKeyerCore::STATUS_BUSY |
+                  WinKeyerCore::STATUS_KEYDOWN, false);
+    }
+
+    // --- script ---
+
+    void after(int ms) {
+        loop_.addTimer(Clock::now() + std::chrono::milliseconds(ms), [this] { nextStep(); });
+    }
+
+    void nextStep() {
+        if (step_ >= script_.size()) {
+            return;
+        }
+        const Step& s = script_[step_++];
+        if (s.op == "wait") {
+            after(std::atoi(s.arg.c_str()));
+        } else if (s.op == "send") {
+            paddleText_ = s.arg;
+            paddleChar_ = 0;
+            setStatus(WinKeyerCore::STATUS_BREAKIN, true);
+            paddleNext();
+        } else if (s.op == "pot") {
+            potPos_ = static_cast<unsigned char>(std::atoi(s.arg.c_str()));
+            emit(0x80 | (potPos_ & 0x3F));
+            nextStep();
+        } else if (s.op == "status" || s.op == "raw") {
+            std::istringstream in(s.arg);
+            std::string tok;
+            while (in >> tok) {
+                emit(static_cast<unsigned char>(std::strtoul(tok.c_str(), nullptr, 0)));
+            }
+            nextStep();
+        } else if (s.op == "quit") {
+            // Closing the master hangs up the slave and drops unread input,
+            // so give the host a moment to read the last bytes.
+            loop_.addTimer(Clock::now() + std::chrono::milliseconds(200), [this] { loop_.stop(); });
+        } else {
+            std::cerr << "Unknown script step: " << s.op << "\n";
+            nextStep();
+        }
+    }
+
+    // Paddle characters are echoed once they have been keyed.
+    void paddleNext() {
+        if (paddleChar_ >= paddleText_.size()) {
+            setStatus(WinKeyerCore::STATUS_BREAKIN, false);
+            nextStep();
+            return;
+        }
+        char ch = paddleText_[paddleChar_++];
+        keyChar(paddleKeying_, ch, [this, ch] {
+            if (mode_ & 0x40) emit(static_cast<unsigned char>(ch));   // paddle echo
+            paddleNext();
+        });
+    }
+
+    int master_;
+    std::vector<Step> script_;
+    size_t step_ = 0;
+    bool scriptStarted_ = false;
+    bool verbose_;
+    EventLoop loop_;
+    std::vector<unsigned char> pending_;
+
+    bool hostOpen_ = false;
+    unsigned char status_ = 0;
+    int wpm_ = 20;
+    unsigned char mode_ = 0xC4;
+    unsigned char pinCfg_ = 0x0F;
+    unsigned char potMin_ = 5;
+    unsigned char potRange_ = 30;
+    unsigned char potPos_ = 0;
+
+    std::deque<char> buffer_;
+    Keying hostKeying_;
+    Keying paddleKeying_;
+    std::string paddleText_;
+    size_t paddleChar_ = 0;
+};
+
+void usage() {
+    std::cerr << "Usage: wk_emulator [--link PATH] [--script FILE] [--verbose]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string link;
+    std::string scriptPath;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--link" && i + 1 < argc) {
+            link = argv[++i];
+        } else if (arg == "--script" && i + 1 < argc) {
+            scriptPath = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    std::vector<Step> script;
+    if (!scriptPath.empty() && !loadScript(scriptPath, script)) {
+        std::cerr << "Cannot read script " << scriptPath << "\n";
+        return 1;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        std::cerr << "Cannot create pty: " << strerror(errno) << "\n";
+        return 1;
+    }
+    std::string slavePath = ptsname(master);
+    // Holding the slave open keeps the master readable between hosts, and
+    // raw mode stops the line discipline echoing our replies back to us.
+    int slave = open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave < 0) {
+        std::cerr << "Cannot open " << slavePath << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    struct termios tty;
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    if (!link.empty()) {
+        unlink(link.c_str());
+        if (symlink(slavePath.c_str(), link.c_str()) != 0) {
+            std::cerr << "Cannot link " << link << ": " << strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    std::cout << "WinKeyer emulator on " << slavePath << std::endl;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    int rc = Emulator(master, std::move(script), verbose).run();
+
+    if (!link.empty()) {
+        unlink(link.c_str());
+    }
+    close(slave);
+    close(master);
+    return rc;
+}
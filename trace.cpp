@@ -0,0 +1,165 @@
+#include "trace.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace MorseCore {
+
+namespace {
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    int64_t startNs;   // since the trace began
+    int64_t durationNs;
+};
+
+// Events go into fixed chunks that are never moved, so the writer can
+// read a chunk while its thread is still filling it: `used` is only
+// ever raised, after the event it covers is in place.
+struct TraceChunk {
+    static const size_t EVENTS = 512;
+    TraceEvent events[EVENTS];
+    std::atomic<size_t> used{0};
+    std::atomic<TraceChunk*> next{nullptr};
+};
+
+struct ThreadTrace {
+    int tid;
+    std::atomic<const char*> name{nullptr};
+    TraceChunk* head;
+    TraceChunk* tail;   // touched only by the owning thread
+};
+
+// Threads register once, under the mutex; after that recording is
+// theirs alone. Nothing here is ever freed: a short-lived render
+// worker's spans must outlive it, and the audio thread may still be
+// recording while the program exits.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<ThreadTrace*> threads;
+    std::string path;
+    TraceClock::time_point origin;
+    std::atomic<bool> recording{false};
+
+    bool write() {
+        std::vector<ThreadTrace*> snapshot;
+        std::string out;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            snapshot = threads;
+            out = path;
+        }
+        FILE* f = std::fopen(out.c_str(), "w");
+        if (!f) return false;
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+        bool first = true;
+        auto separator = [&] {
+            if (!first) std::fputs(",\n", f);
+            first = false;
+        };
+        for (ThreadTrace* t : snapshot) {
+            const char* name = t->name.load(std::memory_order_acquire);
+            separator();
+            std::fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                         t->tid);
+            if (name) {
+                writeEscaped(f, name);
+            } else {
+                std::fprintf(f, "thread %d", t->tid);
+            }
+            std::fputs("\"}}", f);
+            for (TraceChunk* c = t->head; c; c = c->next.load(std::memory_order_acquire)) {
+                size_t used = c->used.load(std::memory_order_acquire);
+                for (size_t i = 0; i < used; ++i) {
+                    const TraceEvent& e = c->events[i];
+                    separator();
+                    std::fputs("{\"ph\":\"X\",\"cat\":\"", f);
+                    writeEscaped(f, e.category);
+                    std::fputs("\",\"name\":\"", f);
+                    writeEscaped(f, e.name);
+                    std::fprintf(f, "\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                 t->tid, e.startNs / 1000.0, e.durationNs / 1000.0);
+                }
+            }
+        }
+        std::fputs("\n]}\n", f);
+        return std::fclose(f) == 0;
+    }
+
+    static void writeEscaped(FILE* f, const char* s) {
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', f);
+            if (static_cast<unsigned char>(*s) >= 0x20) std::fputc(*s, f);
+        }
+    }
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry* r = new TraceRegistry;
+    return *r;
+}
+
+// Writes the trace when the program exits.
+struct WriteAtExit {
+    ~WriteAtExit() { traceStop(); }
+} writeAtExit;
+
+ThreadTrace& threadTrace() {
+    thread_local ThreadTrace* mine = nullptr;
+    if (!mine) {
+        TraceRegistry& r = registry();
+        mine = new ThreadTrace;
+        mine->head = mine->tail = new TraceChunk;
+        std::lock_guard<std::mutex> lock(r.mutex);
+        mine->tid = static_cast<int>(r.threads.size()) + 1;
+        r.threads.push_back(mine);
+    }
+    return *mine;
+}
+
+} // namespace
+
+void traceStart(const std::string& path) {
+    TraceRegistry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.path = path;
+        r.origin = TraceClock::now();
+    }
+    r.recording = true;
+}
+
+bool traceStop() {
+    TraceRegistry& r = registry();
+    if (!r.recording.exchange(false)) return true;
+    return r.write();
+}
+
+void traceComplete(const char* category, const char* name,
+                   TraceClock::time_point start, TraceClock::time_point end) {
+    TraceRegistry& r = registry();
+    if (!r.recording.load(std::memory_order_acquire)) return;
+    ThreadTrace& t = threadTrace();
+    TraceChunk* c = t.tail;
+    size_t n = c->used.load(std::memory_order_relaxed);
+    if (n == TraceChunk::EVENTS) {
+        TraceChunk* fresh = new TraceChunk;
+        c->next.store(fresh, std::memory_order_release);
+        t.tail = c = fresh;
+        n = 0;
+    }
+    c->events[n] = {category, name,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(start - r.origin).count(),
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()};
+    c->used.store(n + 1, std::memory_order_release);
+}
+
+void traceThreadName(const char* name) {
+    threadTrace().name.store(name, std::memory_order_release);
+}
+
+} // end namespace MorseCore
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// ------------------------------------------------------------
+// Span tracing, built in only with -DCW_ENABLE_TRACING=ON. Spans
+// mark question selection, synthesis, playback, waiting for input,
+// grading and persistence; traceStart() names a file and at exit
+// (or traceStop()) they are written as Chrome trace-event JSON,
+// which Perfetto (ui.perfetto.dev) and chrome://tracing open.
+//
+// Each thread appends to buffers of its own, so recording takes no
+// lock: a span costs two clock reads and a store. Without the build
+// option the macros expand to nothing and their arguments are not
+// evaluated.
+//
+//     CW_TRACE_SPAN("grade", "gradeCopy");         // to end of scope
+//     CW_TRACE_COMPLETE("input", "answer", shown, ev.when);
+//     CW_TRACE_THREAD("audio");                     // names this thread
+// ------------------------------------------------------------
+#ifdef CW_ENABLE_TRACING
+
+namespace MorseCore {
+
+using TraceClock = std::chrono::steady_clock;
+
+// Starts recording; the trace goes to `path` at exit.
+void traceStart(const std::string& path);
+// Writes the trace now and stops recording. False if it could not
+// be written.
+bool traceStop();
+
+// A finished span. category and name must outlive the program
+// (string literals).
+void traceComplete(const char* category, const char* name,
+                   TraceClock::time_point start, TraceClock::time_point end);
+void traceThreadName(const char* name);
+
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name)
+        : category_(category), name_(name), start_(TraceClock::now()) {}
+    ~TraceSpan() { traceComplete(category_, name_, start_, TraceClock::now()); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    TraceClock::time_point start_;
+};
+
+} // end namespace MorseCore
+
+#define CW_TRACE_CONCAT2(a, b) a##b
+#define CW_TRACE_CONCAT(a, b) CW_TRACE_CONCAT2(a, b)
+#define CW_TRACE_SPAN(category, name) \
+    ::MorseCore::TraceSpan CW_TRACE_CONCAT(traceSpan_, __LINE__)(category, name)
+#define CW_TRACE_COMPLETE(category, name, start, end) \
+    ::MorseCore::traceComplete(category, name, start, end)
+#define CW_TRACE_THREAD(name) ::MorseCore::traceThreadName(name)
+
+#else
+
+#define CW_TRACE_SPAN(category, name) static_cast<void>(0)
+#define CW_TRACE_COMPLETE(category, name, start, end) static_cast<void>(0)
+#define CW_TRACE_THREAD(name) static_cast<void>(0)
+
+#endif
@@ -0,0 +1,108 @@
+#include "trainer_session.h"
+
+#include <ctime>
+
+#include "copy_grading.h"
+#include "trace.h"
+
+namespace MorseCore {
+
+Session::Session(const SessionConfig& config, ItemTally* persistentMisses)
+    : config_(config),
+      persistentMisses_(persistentMisses),
+      rng_(config.seed ? config.seed : static_cast<unsigned int>(time(nullptr))),
+      timing_(makeTiming(config.wpm, config.effectiveWpm)) {}
+
+bool Session::finished() const {
+    return config_.pool.empty() || questionIndex_ >= config_.numQuestions;
+}
+
+const std::string& Session::nextQuestion() {
+    CW_TRACE_SPAN("select", "nextQuestion");
+    ++questionIndex_;
+    metrics().questions.add();
+    switch (config_.selection) {
+    case Selection::Unique:
+        question_ = sampleQuestion(config_.pool, used_, rng_);
+        break;
+    case Selection::Random:
+        question_ = config_.pool[
+            std::uniform_int_distribution<size_t>(0, config_.pool.size() - 1)(rng_)];
+        break;
+    case Selection::Weighted:
+        question_ = persistentMisses_
+            ? pickWeighted(*persistentMisses_, config_.pool, rng_)
+            : pickWeighted(ItemTally(), config_.pool, rng_);
+        break;
+    }
+    const ItemCatalog& items = catalog();
+    renderer_ = MessageRenderer(items.sendingText(question_), config_.pitch, timing_);
+    audioLength_ = items.audioLength(question_, timing_);
+    lastToneEnd_ = items.lastToneEnd(question_, timing_);
+    return items.text(question_);
+}
+
+void Session::setSpeed(int wpm, int effectiveWpm) {
+    config_.wpm = wpm;
+    config_.effectiveWpm = effectiveWpm;
+    timing_ = makeTiming(wpm, effectiveWpm);
+}
+
+size_t Session::renderAudio(short* buf, size_t capacity) {
+    return renderer_.render(buf, capacity);
+}
+
+Grade Session::submitAnswer(const std::string& answer, double responseSec) {
+    return record(answer, config_.timeLimitSec > 0.0 && responseSec > config_.timeLimitSec);
+}
+
+Grade Session::expire(const std::string& partialAnswer) {
+    return record(partialAnswer, true);
+}
+
+bool Session::matches(const std::string& answer) const {
+    return catalog().matches(question_, answer);
+}
+
+Grade Session::record(const std::string& answer, bool timedOut) {
+    CW_TRACE_SPAN("grade", "Session::record");
+    answeredAt_ = std::chrono::steady_clock::now();
+    Grade g;
+    g.expected = catalog().text(question_);
+    g.timedOut = timedOut;
+    g.matched = matches(answer);
+    g.correct = g.matched && !g.timedOut;
+
+    stats_.items.count(question_, g.correct);
+    stats_.asked++;
+    if (g.timedOut) stats_.timedOut++;
+    if (g.correct) {
+        stats_.correct++;
+    } else {
+        stats_.missed.push_back(question_);
+        if (persistentMisses_) {
+            countPersistentMiss(answer);
+        }
+    }
+    return g;
+}
+
+void Session::countPersistentMiss(const std::string& answer) {
+    ItemCatalog& items = catalog();
+    if (items.kind(question_) != ItemKind::Callsign) {
+        persistentMisses_->grow(question_);
+        ++persistentMisses_->missed[question_];
+        return;
+    }
+    // Generated calls are rarely asked twice, so the miss goes to the
+    // characters that were copied wrong or dropped instead.
+    for (const CopyError& e : gradeCopy(items.text(question_), answer).errors) {
+        ItemId c = e.kind == CopyError::Insertion ? NO_ITEM : items.character(e.sent);
+        if (c != NO_ITEM) {
+            persistentMisses_->grow(c);
+            ++persistentMisses_->missed[c];
+        }
+    }
+}
+
+} // end namespace MorseCore
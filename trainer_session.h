@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "item_catalog.h"
+#include "metrics.h"
+#include "morse_core.h"
+
+// ------------------------------------------------------------
+// Headless training session. A front-end creates a Session, asks
+// it for questions, pulls the audio into its own buffers, submits
+// the student's answers and reads back the stats. Every call
+// returns immediately; timing and I/O are the caller's business.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+enum class Selection {
+    Unique,    // no repeats until the pool is exhausted
+    Random,    // independent uniform picks
+    Weighted   // spaced repetition, weighted by all-time misses
+};
+
+struct SessionConfig {
+    std::vector<ItemId> pool;   // from catalog()
+    int numQuestions = 10;
+    Selection selection = Selection::Unique;
+    float pitch = 800.0f;
+    int wpm = 20;
+    int effectiveWpm = 10;
+    double timeLimitSec = 0.0;  // 0 = untimed
+    unsigned int seed = 0;      // 0 = seed from the clock
+};
+
+struct Grade {
+    bool correct;    // matched and in time
+    bool matched;    // matched, regardless of time
+    bool timedOut;
+    std::string expected;
+};
+
+struct SessionStats {
+    int asked = 0;
+    int correct = 0;
+    int timedOut = 0;
+    ItemTally items;
+    std::vector<ItemId> missed;  // in the order they were missed
+
+    double accuracy() const { return asked > 0 ? 100.0 * correct / asked : 0.0; }
+};
+
+class Session {
+public:
+    // persistentMisses, when given, drives Selection::Weighted and its
+    // missed column is updated on every miss (for a callsign, on each
+    // character copied wrong); the caller owns loading and saving it.
+    explicit Session(const SessionConfig& config, ItemTally* persistentMisses = nullptr);
+
+    bool finished() const;
+    int questionNumber() const { return questionIndex_; }   // 1-based once started
+    int numQuestions() const { return config_.numQuestions; }
+
+    // Moves to the next question and prepares its audio.
+    const std::string& nextQuestion();
+    const std::string& currentQuestion() const { return catalog().text(question_); }
+    ItemId currentItem() const { return question_; }
+
+    // Pulls the current question's audio into buf. Returns the number of
+    // samples written, 0 once all of it has been delivered.
+    size_t renderAudio(short* buf, size_t capacity);
+    size_t audioLength() const { return audioLength_; }
+    size_t lastToneEnd() const { return lastToneEnd_; }
+    int sampleRate() const { return timing_.sampleRate; }
+
+    // Grades an answer for the current question (case-insensitive).
+    // responseSec is checked against the configured time limit.
+    Grade submitAnswer(const std::string& answer, double responseSec = 0.0);
+    // Whether answer is right for the current question, without
+    // recording anything.
+    bool matches(const std::string& answer) const;
+
+    // Records the current question as timed out with whatever the
+    // student had entered so far.
+    Grade expire(const std::string& partialAnswer);
+
+    // When the last answer or expiry was recorded; the epoch before
+    // the first. Front-ends time the gap to the next question's tone.
+    std::chrono::steady_clock::time_point answeredAt() const { return answeredAt_; }
+
+    const SessionStats& stats() const { return stats_; }
+    const SessionConfig& config() const { return config_; }
+
+    // Speed for the questions from the next one on (adaptive speed).
+    void setSpeed(int wpm, int effectiveWpm);
+
+private:
+    Grade record(const std::string& answer, bool timedOut);
+    void countPersistentMiss(const std::string& answer);
+
+    SessionConfig config_;
+    ItemTally* persistentMisses_;
+    std::mt19937 rng_;
+    Timing timing_;
+    std::vector<bool> used_;   // per pool entry, for Selection::Unique
+    int questionIndex_ = 0;
+    ItemId question_ = NO_ITEM;
+    MessageRenderer renderer_;
+    size_t audioLength_ = 0;
+    size_t lastToneEnd_ = 0;
+    SessionStats stats_;
+    std::chrono::steady_clock::time_point answeredAt_;
+    GaugeHold active_{metrics().activeSessions};
+};
+
+} // end namespace MorseCore
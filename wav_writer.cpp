@@ -0,0 +1,108 @@
+#include "wav_writer.h"
+
+#include <algorithm>
+
+namespace MorseCore {
+
+namespace {
+
+void put16(unsigned char*& p, uint16_t v) {
+    *p++ = static_cast<unsigned char>(v & 0xFF);
+    *p++ = static_cast<unsigned char>(v >> 8);
+}
+
+void put32(unsigned char*& p, uint32_t v) {
+    put16(p, static_cast<uint16_t>(v & 0xFFFF));
+    put16(p, static_cast<uint16_t>(v >> 16));
+}
+
+// Largest data size a RIFF header can state.
+const uint32_t MAX_DATA_BYTES = 0xFFFFFFFFu - 36;
+
+} // namespace
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string& path, int sampleRate) {
+    close();
+    path_ = path;
+    sampleRate_ = static_cast<uint32_t>(sampleRate);
+    samples_ = 0;
+    if (path == "-") {
+        file_ = stdout;
+        seekable_ = false;
+    } else {
+        file_ = std::fopen(path.c_str(), "wb");
+        seekable_ = true;
+    }
+    if (!file_) {
+        error_ = "could not write '" + path + "'";
+        return false;
+    }
+    return writeHeader(MAX_DATA_BYTES);
+}
+
+bool WavWriter::writeHeader(uint32_t dataBytes) {
+    unsigned char header[44];
+    unsigned char* p = header;
+    std::copy_n("RIFF", 4, p); p += 4;
+    put32(p, 36 + dataBytes);
+    std::copy_n("WAVEfmt ", 8, p); p += 8;
+    put32(p, 16);                // fmt chunk size
+    put16(p, 1);                 // PCM
+    put16(p, 1);                 // mono
+    put32(p, sampleRate_);
+    put32(p, sampleRate_ * 2);   // bytes per second
+    put16(p, 2);                 // bytes per frame
+    put16(p, 16);                // bits per sample
+    std::copy_n("data", 4, p); p += 4;
+    put32(p, dataBytes);
+    if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+        error_ = "write to '" + path_ + "' failed";
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::write(const short* samples, size_t count) {
+    unsigned char buffer[4096];
+    while (count > 0) {
+        size_t n = std::min(count, sizeof(buffer) / 2);
+        unsigned char* p = buffer;
+        for (size_t i = 0; i < n; ++i) {
+            put16(p, static_cast<uint16_t>(samples[i]));
+        }
+        if (std::fwrite(buffer, 2, n, file_) != n) {
+            error_ = "write to '" + path_ + "' failed";
+            return false;
+        }
+        samples += n;
+        count -= n;
+        samples_ += n;
+    }
+    return true;
+}
+
+bool WavWriter::close() {
+    if (!file_) {
+        return true;
+    }
+    bool ok = true;
+    if (seekable_) {
+        uint32_t dataBytes = static_cast<uint32_t>(std::min<uint64_t>(samples_ * 2, MAX_DATA_BYTES));
+        ok = std::fseek(file_, 0, SEEK_SET) == 0 && writeHeader(dataBytes);
+    }
+    ok = (std::fflush(file_) == 0) && ok;
+    if (file_ != stdout) {
+        ok = (std::fclose(file_) == 0) && ok;
+    }
+    file_ = nullptr;
+    if (!ok && error_.empty()) {
+        error_ = "write to '" + path_ + "' failed";
+    }
+    return ok;
+}
+
+} // end namespace MorseCore
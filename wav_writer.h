@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// ------------------------------------------------------------
+// 16-bit mono WAV output, written as it goes so memory use does
+// not grow with the length of the recording. The header sizes are
+// filled in on close() when the output is a file; on a pipe they
+// stay at their maximum, which is how streaming WAV readers (sox,
+// flac, oggenc) expect an open-ended stream.
+// ------------------------------------------------------------
+namespace MorseCore {
+
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter();
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    // "-" writes to stdout.
+    bool open(const std::string& path, int sampleRate);
+    bool write(const short* samples, size_t count);
+    bool close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    uint64_t samplesWritten() const { return samples_; }
+    const std::string& error() const { return error_; }
+
+private:
+    bool writeHeader(uint32_t dataBytes);
+
+    std::FILE* file_ = nullptr;
+    bool seekable_ = false;
+    std::string path_;
+    uint32_t sampleRate_ = 0;
+    uint64_t samples_ = 0;
+    std::string error_;
+};
+
+} // end namespace MorseCore
@@ -0,0 +1,57 @@
+#pragma once
+
+// ------------------------------------------------------------
+// WinKeyer host-mode protocol helpers (no serial I/O in here).
+// ------------------------------------------------------------
+namespace WinKeyerCore {
+
+// Every byte the keyer sends is one of these, told apart by the top bits.
+enum class ByteKind {
+    Echo,      // 0xxxxxxx: echoed character from the paddles
+    SpeedPot,  // 10xxxxxx: speed pot position
+    Status     // 11xxxxxx: status byte
+};
+
+inline ByteKind classify(unsigned char b) {
+    if ((b & 0xC0) == 0xC0) return ByteKind::Status;
+    if ((b & 0xC0) == 0x80) return ByteKind::SpeedPot;
+    return ByteKind::Echo;
+}
+
+// Low bits of a status byte.
+const unsigned char STATUS_XOFF    = 0x01;  // keyer buffer more than 2/3 full
+const unsigned char STATUS_BREAKIN = 0x02;  // paddle break-in active
+const unsigned char STATUS_BUSY    = 0x04;  // keyer is sending
+const unsigned char STATUS_KEYDOWN = 0x08;  // key is down
+const unsigned char STATUS_WAIT    = 0x10;  // keyer is waiting on an internal event
+
+// Host bytes below 0x18 are immediate commands, acted on as they
+// arrive even with the buffer full. Everything else (text and the
+// buffered commands 0x18-0x1F) joins the keyer's buffer in turn.
+inline bool isImmediateCommand(unsigned char b) {
+    return b < 0x18;
+}
+
+// Parameter bytes that follow a buffered command (0 for text).
+inline int bufferedParams(unsigned char b) {
+    switch (b) {
+    case 0x18:   // buffered PTT on/off
+    case 0x19:   // key buffered
+    case 0x1A:   // buffered wait
+    case 0x1C:   // buffered speed
+    case 0x1D:   // HSCW speed
+        return 1;
+    case 0x1B:   // merge letters
+        return 2;
+    default:     // 0x1E cancel buffered speed, 0x1F NOP, text
+        return 0;
+    }
+}
+
+// Maps a speed pot byte onto the configured min..max WPM range.
+inline int potToWpm(unsigned char b, int minWpm, int maxWpm) {
+    int potVal = b & 0x7F;
+    return minWpm + (potVal * (maxWpm - minWpm)) / 31;
+}
+
+} // end namespace WinKeyerCore
@@ -0,0 +1,325 @@
+#include "winkeyer_serial.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "metrics.h"
+#include "trace.h"
+
+namespace {
+
+const size_t READ_BLOCK = 256;
+
+} // namespace
+
+WinKeyerPort::~WinKeyerPort() {
+    close();
+}
+
+bool WinKeyerPort::open(const std::string& device) {
+    close();
+    int fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        error_ = "Error opening " + device + ": " + strerror(errno);
+        return false;
+    }
+    struct termios tty;
+    memset(&tty, 0, sizeof(tty));
+    if (tcgetattr(fd, &tty) != 0) {
+        error_ = std::string("tcgetattr error: ") + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, B1200);
+    cfsetospeed(&tty, B1200);
+    tty.c_cflag |= CSTOPB;
+    tty.c_cflag &= ~CRTSCTS;
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~CSIZE;
+    tty.c_cflag |= CS8;
+    tty.c_cflag &= ~PARENB;
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        error_ = std::string("tcsetattr() error: ") + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    status_ = 0;
+    hungUp_ = false;
+    events_.clear();
+    immediateQueue_.clear();
+    outQueue_.clear();
+    commandLeft_ = 0;
+    return true;
+}
+
+void WinKeyerPort::close() {
+    detach();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool WinKeyerPort::readAvailable() {
+    unsigned char buf[READ_BLOCK];
+    for (;;) {
+        ssize_t n = read(fd_, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (n == 0) {
+            return false;
+        }
+        Clock::time_point now = Clock::now();
+        MorseCore::metrics().winkeyerBytesIn.add(static_cast<uint64_t>(n));
+        for (ssize_t i = 0; i < n; ++i) {
+            WinKeyerCore::ByteKind kind = WinKeyerCore::classify(buf[i]);
+            if (kind == WinKeyerCore::ByteKind::Status) {
+                status_ = buf[i];
+                if (statusHandler_) {
+                    statusHandler_(status_, now);
+                }
+            }
+            events_.push_back({kind, buf[i], now});
+        }
+        if (static_cast<size_t>(n) < sizeof(buf)) {
+            return true;
+        }
+    }
+}
+
+bool WinKeyerPort::readRawByte(unsigned char& b, int timeoutMs) {
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return false;
+    }
+    if (read(fd_, &b, 1) != 1) {
+        return false;
+    }
+    MorseCore::metrics().winkeyerBytesIn.add();
+    return true;
+}
+
+bool WinKeyerPort::waitForStatus(int timeoutMs) {
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    size_t seen = events_.size();
+    for (;;) {
+        flushOutput();
+        for (; seen < events_.size(); ++seen) {
+            if (events_[seen].kind == WinKeyerCore::ByteKind::Status) {
+                return true;
+            }
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0) {
+            return false;
+        }
+        short want = POLLIN | (canWrite() ? POLLOUT : 0);
+        struct pollfd pfd = {fd_, want, 0};
+        if (poll(&pfd, 1, static_cast<int>(left)) < 0 && errno != EINTR) {
+            return false;
+        }
+        if ((pfd.revents & (POLLIN | POLLHUP | POLLERR)) && !readAvailable()) {
+            return false;
+        }
+    }
+}
+
+bool WinKeyerPort::nextEvent(Event& ev) {
+    if (events_.empty()) {
+        return false;
+    }
+    ev = events_.front();
+    events_.pop_front();
+    return true;
+}
+
+bool WinKeyerPort::send(const unsigned char* data, size_t length) {
+    MorseCore::metrics().winkeyerCommands.add();
+    std::deque<unsigned char>& queue =
+        length > 0 && WinKeyerCore::isImmediateCommand(data[0]) ? immediateQueue_ : outQueue_;
+    queue.insert(queue.end(), data, data + length);
+    return flushOutput();
+}
+
+bool WinKeyerPort::sendCommand(unsigned char c1) {
+    return send(&c1, 1);
+}
+
+bool WinKeyerPort::sendCommand(unsigned char c1, unsigned char c2) {
+    unsigned char buf[2] = { c1, c2 };
+    return send(buf, 2);
+}
+
+bool WinKeyerPort::flushOutput() {
+    if (!loop_ && xoff()) {
+        // Nobody is reading for us; pick up any newer status byte.
+        readAvailable();
+    }
+    bool ok = true;
+    // The rest of a buffered command already begun goes first, held
+    // or not, so an immediate command cannot land among its parameters.
+    size_t owed = std::min(static_cast<size_t>(commandLeft_), outQueue_.size());
+    if (writeQueued(outQueue_, owed, ok) == owed) {
+        writeQueued(immediateQueue_, immediateQueue_.size(), ok);
+        if (ok && immediateQueue_.empty() && !xoff()) {
+            writeQueued(outQueue_, outQueue_.size(), ok);
+        }
+    }
+    updateWatch();
+    return ok;
+}
+
+// Writes up to count bytes from the front of queue; returns how many
+// went. Stops early when the driver is full or on an error (ok false).
+size_t WinKeyerPort::writeQueued(std::deque<unsigned char>& queue, size_t count, bool& ok) {
+    size_t written = 0;
+    while (written < count) {
+        // The queue is small; copy a contiguous run for write().
+        unsigned char buf[READ_BLOCK];
+        size_t n = std::min(count - written, sizeof(buf));
+        std::copy(queue.begin(), queue.begin() + n, buf);
+        ssize_t w = write(fd_, buf, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                error_ = std::string("Error writing to serial port: ") + strerror(errno);
+                ok = false;
+            }
+            break;
+        }
+        if (&queue == &outQueue_) {
+            for (ssize_t i = 0; i < w; ++i) {
+                commandLeft_ = commandLeft_ > 0 ? commandLeft_ - 1 : WinKeyerCore::bufferedParams(buf[i]);
+            }
+        }
+        MorseCore::metrics().winkeyerBytesOut.add(static_cast<uint64_t>(w));
+        queue.erase(queue.begin(), queue.begin() + w);
+        written += static_cast<size_t>(w);
+    }
+    return written;
+}
+
+bool WinKeyerPort::canWrite() const {
+    return !immediateQueue_.empty() ||
+           (!outQueue_.empty() && (commandLeft_ > 0 || !xoff()));
+}
+
+void WinKeyerPort::attach(EventLoop& loop, EventHandler handler) {
+    if (loop_ && loop_ != &loop) {
+        detach();
+    }
+    loop_ = &loop;
+    handler_ = std::move(handler);
+    held_ = false;
+    watchingOutput_ = false;
+    loop.watch(fd_, [this](uint32_t events) { onReady(events); });
+    updateWatch();
+    // Events left over from before the last detach() go out first, but
+    // from the loop rather than from inside the caller.
+    if (!events_.empty() && dispatchTimer_ < 0) {
+        dispatchTimer_ = loop.addTimer(Clock::now(), [this] {
+            dispatchTimer_ = -1;
+            dispatch();
+        });
+    }
+}
+
+void WinKeyerPort::detach() {
+    if (!loop_) {
+        return;
+    }
+    if (dispatchTimer_ >= 0) {
+        loop_->cancelTimer(dispatchTimer_);
+        dispatchTimer_ = -1;
+    }
+    loop_->unwatch(fd_);
+    loop_ = nullptr;
+    handler_ = nullptr;
+    held_ = false;
+}
+
+void WinKeyerPort::hold() {
+    if (!loop_) {
+        return;
+    }
+    held_ = true;
+    if (dispatchTimer_ >= 0) {
+        loop_->cancelTimer(dispatchTimer_);
+        dispatchTimer_ = -1;
+    }
+}
+
+void WinKeyerPort::onReady(uint32_t events) {
+    bool ok = true;
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ok = readAvailable();
+    }
+    flushOutput();
+    dispatch();
+    if (!ok && loop_) {
+        // Device gone; stop the loop from spinning on the hang-up.
+        error_ = "Serial port closed";
+        hungUp_ = true;
+        detach();
+    }
+}
+
+void WinKeyerPort::dispatch() {
+    CW_TRACE_SPAN("input", "keyer bytes");
+    Event ev;
+    // The handler may detach, hold or re-attach with another handler
+    // mid-batch.
+    while (loop_ && !held_ && nextEvent(ev)) {
+        EventHandler handler = handler_;
+        handler(ev);
+    }
+}
+
+void WinKeyerPort::updateWatch() {
+    if (!loop_) {
+        return;
+    }
+    bool wantOutput = canWrite();
+    if (wantOutput != watchingOutput_) {
+        loop_->watch(fd_, [this](uint32_t events) { onReady(events); },
+                     EPOLLIN | (wantOutput ? uint32_t(EPOLLOUT) : 0u));
+        watchingOutput_ = wantOutput;
+    }
+}
+
+std::vector<std::string> findKeyerDevices() {
+    std::vector<std::pair<std::string, long>> found;
+    DIR* dir = opendir("/dev");
+    if (!dir) {
+        return {};
+    }
+    while (struct dirent* ent = readdir(dir)) {
+        std::string name = ent->d_name;
+        for (const char* prefix : {"ttyUSB", "ttyACM"}) {
+            size_t len = strlen(prefix);
+            if (name.size() > len && name.compare(0, len, prefix) == 0 &&
+                name.find_first_not_of("0123456789", len) == std::string::npos) {
+                found.push_back({name.substr(0, len), std::stol(name.substr(len))});
+            }
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> devices;
+    for (const auto& f : found) {
+        devices.push_back("/dev/" + f.first + std::to_string(f.second));
+    }
+    return devices;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "event_loop.h"
+#include "winkeyer_core.h"
+
+// ------------------------------------------------------------
+// Non-blocking WinKeyer serial port. Input is read in blocks and
+// decoded into timestamped events. Text and buffered commands go
+// through a queue that is held while the keyer reports XOFF and
+// drained as soon as it clears; immediate commands (clear buffer,
+// speed, admin) skip ahead of it and are never held.
+// ------------------------------------------------------------
+class WinKeyerPort {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        WinKeyerCore::ByteKind kind;
+        unsigned char byte;
+        Clock::time_point when;   // time the block holding the byte was read
+    };
+    using EventHandler = std::function<void(const Event&)>;
+    using StatusHandler = std::function<void(unsigned char status, Clock::time_point when)>;
+
+    WinKeyerPort() = default;
+    ~WinKeyerPort();
+    WinKeyerPort(const WinKeyerPort&) = delete;
+    WinKeyerPort& operator=(const WinKeyerPort&) = delete;
+
+    // Opens device raw at 1200 baud, 8N2, non-blocking.
+    bool open(const std::string& device);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    const std::string& error() const { return error_; }
+    // True once the device has gone away under an attached loop.
+    bool hungUp() const { return hungUp_; }
+
+    // Reads whatever the driver holds, decoding it into the event queue.
+    // Returns false on a read error or hang-up.
+    bool readAvailable();
+    // Waits up to timeoutMs for one byte and returns it undecoded (the
+    // firmware version reply is not part of the event stream).
+    bool readRawByte(unsigned char& b, int timeoutMs);
+    // Writes queued output and reads until a status byte arrives or
+    // timeoutMs passes. Everything read stays in the event queue.
+    bool waitForStatus(int timeoutMs);
+    bool nextEvent(Event& ev);
+    void discardEvents() { events_.clear(); }
+
+    // Queues bytes for the keyer and writes as many as flow control
+    // allows. A write that starts with an immediate command goes out
+    // ahead of any held text, at the next command boundary.
+    bool send(const unsigned char* data, size_t length);
+    bool sendCommand(unsigned char c1);
+    bool sendCommand(unsigned char c1, unsigned char c2);
+    // Writes immediate commands, then buffered bytes unless the keyer
+    // has signalled XOFF.
+    bool flushOutput();
+    size_t pendingOutput() const { return immediateQueue_.size() + outQueue_.size(); }
+
+    unsigned char status() const { return status_; }
+    bool xoff() const { return status_ & WinKeyerCore::STATUS_XOFF; }
+    bool busy() const { return status_ & WinKeyerCore::STATUS_BUSY; }
+    bool keyDown() const { return status_ & WinKeyerCore::STATUS_KEYDOWN; }
+    // Called for each status byte as it is read, ahead of the event
+    // queue and whether or not a handler is attached, for things like
+    // sidetone that cannot wait their turn. Pass nullptr to remove.
+    void setStatusHandler(StatusHandler handler) { statusHandler_ = std::move(handler); }
+
+    // Delivers events from loop, one at a time, until detach(). Events
+    // read but not yet delivered stay queued for the next attach().
+    // Detach before the loop goes away.
+    void attach(EventLoop& loop, EventHandler handler);
+    void detach();
+    // Stops delivering events until the next attach() but keeps
+    // reading, so the status handler still sees each byte as it comes
+    // (sidetone keeps up through a pause) and output still drains.
+    void hold();
+    bool attached() const { return loop_ != nullptr; }
+
+private:
+    void onReady(uint32_t events);
+    void dispatch();
+    void updateWatch();
+    bool canWrite() const;
+    size_t writeQueued(std::deque<unsigned char>& queue, size_t count, bool& ok);
+
+    int fd_ = -1;
+    std::string error_;
+    unsigned char status_ = 0;
+    bool hungUp_ = false;
+    std::deque<Event> events_;
+    std::deque<unsigned char> immediateQueue_;
+    std::deque<unsigned char> outQueue_;
+    int commandLeft_ = 0;   // parameters owed by a buffered command partly written
+    EventLoop* loop_ = nullptr;
+    EventHandler handler_;
+    StatusHandler statusHandler_;
+    bool watchingOutput_ = false;
+    bool held_ = false;
+    EventLoop::TimerId dispatchTimer_ = -1;
+};
+
+// USB serial devices a WinKeyer may sit behind (/dev/ttyUSB*, /dev/ttyACM*),
+// in numeric order.
+std::vector<std::string> findKeyerDevices();